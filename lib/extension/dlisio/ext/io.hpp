@@ -1,11 +1,21 @@
 #ifndef DLISIO_PYTHON_IO_HPP
 #define DLISIO_PYTHON_IO_HPP
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
 #include <iosfwd>
+#include <map>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <vector>
 
+#include <dlisio/dlisio.h>
 #include <dlisio/ext/types.hpp>
 
 namespace dl {
@@ -21,6 +31,13 @@ struct bookmark {
     int isexplicit = 0;
     int isencrypted = 0;
 
+    /*
+     * the logical record type from the segment header, e.g. DLIS_CHANNL for
+     * an explicit record, which is enough to find the sets of a certain type
+     * without parsing them
+     */
+    int type = 0;
+
     obname name;
 
     /*
@@ -131,14 +148,294 @@ void basic_file< Stream >::close() {
     this->fs.close();
 }
 
+/*
+ * A read-only file with the same interface as basic_file, that reads through
+ * a window of window bytes.
+ *
+ * Indexing reads a few bytes of headers per record, and then skips the body.
+ * Through a plain stream that is several reads and a seek per record, but
+ * when the headers are served from the window, the stream is only read when
+ * the cursor leaves the window. Reads that are larger than the window bypass
+ * it.
+ *
+ * When the cursor is moved past the end of the window, but at most readahead
+ * bytes, the window is refilled from where the stream left off without
+ * seeking, which keeps short skips sequential.
+ *
+ * Reading past the end throws std::out_of_range.
+ */
+template< typename Stream = std::ifstream >
+class buffered_file {
+public:
+    static constexpr std::size_t default_window = 1 << 16;
+
+    explicit buffered_file( const std::string& path,
+                            std::size_t window = default_window,
+                            std::size_t readahead = default_window );
+
+    explicit buffered_file( Stream stream,
+                            std::size_t window = default_window,
+                            std::size_t readahead = default_window );
+
+    template< int N > std::array< char, N > read();
+    std::vector< char > read( std::streamsize nmemb );
+    char* read( char*, std::streamsize nmemb );
+
+    bool eof();
+
+    std::streamsize tell() const noexcept (true);
+    buffered_file& seek( std::streamsize ) noexcept (true);
+    buffered_file& skip( std::streamsize ) noexcept (true);
+
+    void close();
+
+    /* number of reads issued to the underlying stream */
+    std::size_t refills() const noexcept (true);
+
+private:
+    Stream fs;
+    std::vector< char > buffer;
+    std::size_t readahead;
+
+    /* the window is [start, start + len) in the file */
+    std::streamsize start = 0;
+    std::streamsize len = 0;
+    /* the position of the cursor, and of the underlying stream */
+    std::streamsize pos = 0;
+    std::streamsize streampos = 0;
+    std::size_t reads = 0;
+
+    bool buffered() const noexcept (true);
+    std::streamsize fill( char* dst, std::streamsize at, std::streamsize n );
+    void refill();
+};
+
+template< typename Stream >
+buffered_file< Stream >::buffered_file( const std::string& path,
+                                        std::size_t window,
+                                        std::size_t ahead ) :
+    fs( path, std::ios_base::binary | std::ios_base::in ),
+    buffer( std::max< std::size_t >( window, 1 ) ),
+    readahead( ahead )
+{
+    if (!this->fs)
+        throw std::runtime_error( "unable to open " + path );
+}
+
+template< typename Stream >
+buffered_file< Stream >::buffered_file( Stream stream,
+                                        std::size_t window,
+                                        std::size_t ahead ) :
+    fs( std::move( stream ) ),
+    buffer( std::max< std::size_t >( window, 1 ) ),
+    readahead( ahead )
+{
+    this->fs.seekg( 0, std::ios_base::beg );
+}
+
+template< typename Stream >
+template< int N >
+std::array< char, N > buffered_file< Stream >::read() {
+    std::array< char, N > xs;
+    this->read( xs.data(), N );
+    return xs;
+}
+
+template< typename Stream >
+std::vector< char > buffered_file< Stream >::read( std::streamsize nmemb ) {
+    std::vector< char > xs( nmemb );
+    this->read( xs.data(), nmemb );
+    return xs;
+}
+
+template< typename Stream >
+bool buffered_file< Stream >::buffered() const noexcept (true) {
+    return this->start <= this->pos && this->pos < this->start + this->len;
+}
+
+/*
+ * Read up to n bytes at at into dst, and return the number of bytes read.
+ * The stream is only seeked if at is not where the last read left off.
+ */
+template< typename Stream >
+std::streamsize buffered_file< Stream >::fill( char* dst,
+                                               std::streamsize at,
+                                               std::streamsize n ) {
+    if (at != this->streampos) {
+        this->fs.clear();
+        this->fs.seekg( at, std::ios_base::beg );
+        this->streampos = at;
+    }
+
+    this->fs.read( dst, n );
+    const auto count = this->fs.gcount();
+    this->streampos += count;
+    this->reads += 1;
+
+    /* a short read sets eof- and failbit, which would fail the next seek */
+    if (count < n) this->fs.clear();
+    return count;
+}
+
+template< typename Stream >
+void buffered_file< Stream >::refill() {
+    const auto window = static_cast< std::streamsize >( this->buffer.size() );
+    const auto ahead  = static_cast< std::streamsize >( this->readahead );
+
+    auto at = this->pos;
+    const auto gap = this->pos - this->streampos;
+    if (gap > 0 && gap <= ahead && gap < window)
+        at = this->streampos;
+
+    this->start = at;
+    this->len = this->fill( this->buffer.data(), at, window );
+}
+
+template< typename Stream >
+char* buffered_file< Stream >::read( char* dst, std::streamsize nmemb ) {
+    const auto window = static_cast< std::streamsize >( this->buffer.size() );
+    auto* out = dst;
+    auto remaining = nmemb;
+
+    while (remaining > 0) {
+        if (!this->buffered()) {
+            if (remaining >= window) {
+                const auto n = this->fill( out, this->pos, remaining );
+                this->pos += n;
+                remaining -= n;
+                if (remaining > 0) break;
+                return dst;
+            }
+
+            this->refill();
+            if (!this->buffered()) break;
+        }
+
+        const auto offset = this->pos - this->start;
+        const auto count = std::min( remaining, this->len - offset );
+        std::memcpy( out, this->buffer.data() + offset, count );
+        out += count;
+        this->pos += count;
+        remaining -= count;
+    }
+
+    if (remaining == 0) return dst;
+
+    const auto msg = "unexpected end-of-file: reading "
+                   + std::to_string( nmemb ) + " bytes at "
+                   + std::to_string( this->pos - (nmemb - remaining) )
+                   ;
+    throw std::out_of_range( msg );
+}
+
+template< typename Stream >
+bool buffered_file< Stream >::eof() {
+    if (this->buffered()) return false;
+    this->refill();
+    return !this->buffered();
+}
+
+template< typename Stream >
+std::streamsize buffered_file< Stream >::tell() const noexcept (true) {
+    return this->pos;
+}
+
+template< typename Stream >
+buffered_file< Stream >&
+buffered_file< Stream >::seek( std::streamsize n ) noexcept (true) {
+    this->pos = n;
+    return *this;
+}
+
+template< typename Stream >
+buffered_file< Stream >&
+buffered_file< Stream >::skip( std::streamsize n ) noexcept (true) {
+    this->pos += n;
+    return *this;
+}
+
+template< typename Stream >
+void buffered_file< Stream >::close() {
+    this->fs.close();
+}
+
+template< typename Stream >
+std::size_t buffered_file< Stream >::refills() const noexcept (true) {
+    return this->reads;
+}
+
+/*
+ * A read-only, memory-mapped file with the same interface as basic_file.
+ *
+ * Reads are bounds checked against the size of the mapping, and reading past
+ * the end throws std::out_of_range. On top of the basic_file interface,
+ * view() hands out pointers directly into the mapping, so that callers can
+ * parse headers and record bodies without copying them first. These pointers
+ * are valid until the file is closed.
+ */
+class mapped_file {
+public:
+    mapped_file() = default;
+    explicit mapped_file( const std::string& path ) noexcept (false);
+    ~mapped_file();
+
+    mapped_file( const mapped_file& ) = delete;
+    mapped_file& operator = ( const mapped_file& ) = delete;
+    mapped_file( mapped_file&& ) noexcept (true);
+    mapped_file& operator = ( mapped_file&& ) noexcept (true);
+
+    template< int N > std::array< char, N > read();
+    std::vector< char > read( std::streamsize nmemb );
+    char* read( char*, std::streamsize nmemb );
+
+    /*
+     * Get a pointer to the next nmemb bytes and advance, like read, but
+     * without copying
+     */
+    const char* view( std::streamsize nmemb ) noexcept (false);
+
+    bool eof() const noexcept (true);
+
+    std::streamsize tell() const noexcept (true);
+    mapped_file& seek( std::streamsize ) noexcept (true);
+    mapped_file& skip( std::streamsize ) noexcept (true);
+
+    std::streamsize size() const noexcept (true);
+    const char* data() const noexcept (true);
+
+    /*
+     * Hint that [begin, end) will be read soon, so that the operating system
+     * can start reading it in the background. Returns false if hinting is not
+     * supported, in which case nothing is done.
+     */
+    bool advise( std::streamsize begin, std::streamsize end )
+    const noexcept (true);
+
+    void close() noexcept (true);
+
+private:
+    const char* base = nullptr;
+    std::streamsize len = 0;
+    std::streamsize pos = 0;
+    /* the file mapping object, only used on windows */
+    void* handle = nullptr;
+};
+
+template< int N >
+std::array< char, N > mapped_file::read() {
+    std::array< char, N > xs;
+    this->read( xs.data(), N );
+    return xs;
+}
+
 struct segheader {
     std::uint8_t attrs;
     int len;
     int type;
 };
 
-template< typename Stream >
-segheader segment_header( basic_file< Stream >& fs ) {
+template< typename File >
+segheader segment_header( File& fs ) {
     auto buffer = fs.template read< DLIS_LRSH_SIZE >();
 
     segheader seg;
@@ -151,8 +448,8 @@ segheader segment_header( basic_file< Stream >& fs ) {
     return seg;
 }
 
-template< typename Stream >
-int visible_length( basic_file< Stream >& fs ) {
+template< typename File >
+int visible_length( File& fs ) {
     auto buffer = fs.template read< DLIS_VRL_SIZE >();
 
     int len, version;
@@ -169,8 +466,8 @@ int visible_length( basic_file< Stream >& fs ) {
     return len;
 }
 
-template< typename Stream >
-int skiprecord( basic_file< Stream >& fs, int remaining ) {
+template< typename File >
+int skiprecord( File& fs, int remaining ) {
     while( true ) {
 
         /*
@@ -217,11 +514,294 @@ int skiprecord( basic_file< Stream >& fs, int remaining ) {
 }
 
 
+/*
+ * A contiguous run of bytes, owned by someone else (usually a mapped_file)
+ */
+struct span {
+    const char* data = nullptr;
+    std::size_t size = 0;
+};
+
+/*
+ * A logical record, as a series of spans over the bodies of its segments.
+ * Segment headers and trailers (padding, checksum, trailing length) are not
+ * a part of the spans.
+ *
+ * The vast majority of records are not segmented, and then the body is
+ * available as-is with data(), without copying. Segmented records are
+ * concatenated into the caller-provided buffer when data() is called, so
+ * that parsers that want contiguous input can still consume them.
+ */
+struct record_view {
+    std::vector< span > segments;
+
+    bool contiguous() const noexcept (true);
+    std::size_t size() const noexcept (true);
+    const char* data( std::vector< char >& buffer ) const noexcept (false);
+    void clear() noexcept (true);
+
+    /*
+     * Get the bytes [offset, offset + nmemb) of the record, without touching
+     * the rest of it. If the bytes are in a single segment, the pointer is
+     * into that segment, otherwise they are gathered into buffer. Throws
+     * std::out_of_range if the slice goes past the end of the record.
+     */
+    const char* slice( std::size_t offset,
+                       std::size_t nmemb,
+                       std::vector< char >& buffer ) const noexcept (false);
+};
+
+/*
+ * Read the logical record at the current position of the file, which must
+ * be bookmark.tell, with remaining being bookmark.residual. out is cleared
+ * before it's filled, so it can be re-used between calls to avoid
+ * re-allocating the segment list
+ */
+void view_record( mapped_file&, int remaining, record_view& out )
+noexcept (false);
+
+/*
+ * Read the logical record at pos, like view_record above, but without
+ * moving the file position, so that records can be viewed from multiple
+ * threads. Every header is checked against the size of the file, and a
+ * record that runs past the end throws std::out_of_range. Returns the
+ * position right after the record.
+ */
+std::streamsize view_record( const mapped_file&,
+                             std::streamsize pos,
+                             int remaining,
+                             record_view& out )
+noexcept (false);
+
+/*
+ * The layout of the frame data (the IFLR body, after the frame name and
+ * number) of a FRAME, compiled once from its channel list and applied to
+ * every IFLR of that frame.
+ *
+ * The offsets of the channels up to and including the first variable-size
+ * one do not depend on the frame, and are computed up front. The offsets of
+ * the channels after it are discovered with dlis_frame_offsets, by skipping
+ * the variable-size values in the frame body, which only reads their length
+ * prefixes.
+ */
+class frame_plan {
+public:
+    frame_plan() = default;
+
+    /*
+     * The representation code and number of values (the product of the
+     * dimension) of every channel in the frame, in frame order. Throws
+     * std::invalid_argument on invalid representation codes or negative
+     * counts
+     */
+    frame_plan( const std::vector< int >& reprcs,
+                const std::vector< int >& counts ) noexcept (false);
+
+    std::size_t size() const noexcept (true);
+    int reprc( std::size_t channel ) const noexcept (false);
+    int count( std::size_t channel ) const noexcept (false);
+
+    /*
+     * True if both the offset and size of the channel are the same in every
+     * frame, so it can be read without looking at the rest of the frame
+     */
+    bool fixed( std::size_t channel ) const noexcept (false);
+
+    /* the size in bytes of the channel, or 0 if it is variable-size */
+    std::size_t width( std::size_t channel ) const noexcept (false);
+
+    /*
+     * The offset of the channel from the start of the frame body. The body
+     * [body, end) is only read if the channel comes after a variable-size
+     * channel, and then throws std::out_of_range if the channels before it
+     * run past end.
+     */
+    std::size_t offset( std::size_t channel,
+                        const char* body,
+                        const char* end ) const
+    noexcept (false);
+
+private:
+    std::vector< std::int32_t > reprcs;
+    std::vector< std::int32_t > counts;
+    std::vector< std::size_t > widths;
+    /* offsets of the channels with a frame-independent offset */
+    std::vector< std::size_t > offsets;
+};
+
+/*
+ * The plan of a frame from its channel objects, e.g. as resolved by
+ * channel_index::resolve. The count of a channel is the product of its
+ * DIMENSION, or of its ELEMENT-LIMIT if it has no dimension, or 1.
+ */
+frame_plan make_frame_plan( const std::vector< const channel* >& )
+noexcept (false);
+
+/*
+ * The visible records of a file, as a sorted table of label offsets and
+ * lengths.
+ *
+ * Logical records are a stream of bytes that runs through the bodies of the
+ * visible records, skipping the labels. A logical offset counts only the
+ * bytes in that stream, and the table maps between logical offsets and
+ * physical (file) offsets with a binary search, so that any position in a
+ * record can be found without walking the headers before it.
+ */
+class vrl_table {
+public:
+    /* add a visible record, which must come after the ones already added */
+    void push_back( std::int64_t offset, std::int32_t length )
+    noexcept (false);
+
+    std::size_t size() const noexcept (true);
+    void resize( std::size_t ) noexcept (false);
+
+    /*
+     * Find the visible record that contains the physical offset, or throw
+     * std::out_of_range if there is none
+     */
+    std::size_t find( std::int64_t physical ) const noexcept (false);
+
+    std::int64_t physical( std::int64_t logical ) const noexcept (false);
+    std::int64_t logical( std::int64_t physical ) const noexcept (false);
+
+    /*
+     * The bytes left in the visible record after the physical offset, i.e.
+     * the residual of a bookmark at that position
+     */
+    int remaining( std::int64_t physical ) const noexcept (false);
+
+    std::vector< std::int64_t > offsets;
+    std::vector< std::int32_t > lengths;
+    /* logical offset of the first byte after each label */
+    std::vector< std::int64_t > starts;
+};
+
+/*
+ * The position of a sequential scan, i.e. the position in the file and the
+ * bytes left in the current visible record
+ */
+struct scan_state {
+    std::streamsize pos = 0;
+    int remaining = 0;
+};
+
+/*
+ * Bookmark the record at state, like tag(), and advance state to the next
+ * record.
+ *
+ * Every header is bounds-checked against the file size, and problems are
+ * reported as status codes rather than exceptions:
+ *
+ *  DLIS_OK             mark is the record, state is advanced
+ *  DLIS_EOF            state is at the end of the file, no more records
+ *  DLIS_TRUNCATED      the record extends past the end of the file
+ *  DLIS_INCONSISTENT   the record is malformed, e.g. seg.len > vrl.len
+ *
+ * On anything but DLIS_OK state is left untouched, so it points to the
+ * start of the bad record.
+ *
+ * If vrls is not null, the visible records entered are added to it. Only
+ * allocation failures throw.
+ */
+int scan_record( const mapped_file&,
+                 scan_state&,
+                 bookmark& mark,
+                 vrl_table* vrls = nullptr )
+noexcept (false);
+
+/*
+ * Find the next record after a damaged one, for recovering from
+ * scan_record errors.
+ *
+ * The search starts right after state.pos, and looks for the 0xFF 0x01
+ * padding and version bytes of a visible record label (16 bytes at a time,
+ * where SSE2 is available). Every candidate is checked by walking its
+ * segment headers, which must exactly fill the visible record, and by
+ * checking the label that follows. The state is then set to the first
+ * segment in that visible record that starts a record.
+ *
+ * Returns false if no record is found before the end of the file. If the
+ * state is set to the middle of a visible record, and vrls is not null, the
+ * visible record is added to it.
+ */
+bool resync( const mapped_file&,
+             scan_state& state,
+             vrl_table* vrls = nullptr )
+noexcept (false);
+
+/*
+ * A range [begin, end) of bytes in a file
+ */
+struct byte_range {
+    std::streamsize begin = 0;
+    std::streamsize end = 0;
+};
+
+/*
+ * Sort the ranges, and merge those that overlap or are less than gap bytes
+ * apart
+ */
+std::vector< byte_range > coalesce( std::vector< byte_range >,
+                                    std::streamsize gap )
+noexcept (false);
+
+struct record_index;
+
+/*
+ * Views of many records, fetched at once.
+ *
+ * The records are given by their positions in the index. A record ends
+ * where the next record in the file starts, so the bytes of all the records
+ * are known up front, without reading the file. They are merged into as few
+ * ranges as possible, and the operating system is asked to read the ranges
+ * in the background. Where that is not supported, a thread touches the pages
+ * of the ranges ahead of the caller instead.
+ *
+ * The segment headers of a record are only read when it's accessed with
+ * operator [], so that I/O overlaps with decoding the first records. If a
+ * record can't be viewed, e.g. because it runs past the end of the file,
+ * operator [] throws for that record only. Different records may be
+ * accessed from different threads at the same time.
+ *
+ * The views are in the same order as the positions, and encrypted records
+ * get an empty view.
+ */
+class record_batch {
+public:
+    record_batch( const mapped_file&,
+                  const record_index&,
+                  const std::vector< std::size_t >& positions,
+                  std::streamsize gap = 1 << 16 )
+    noexcept (false);
+    ~record_batch();
+
+    record_batch( const record_batch& ) = delete;
+    record_batch& operator = ( const record_batch& ) = delete;
+
+    std::size_t size() const noexcept (true);
+    const record_view& operator [] ( std::size_t ) noexcept (false);
+    const bookmark& mark( std::size_t ) const noexcept (true);
+
+    const std::vector< byte_range >& ranges() const noexcept (true);
+
+private:
+    const mapped_file& file;
+    std::vector< bookmark > marks;
+    std::vector< record_view > views;
+    std::vector< std::exception_ptr > errors;
+    /* char rather than bool, so that every record has its own flag */
+    std::vector< char > fetched;
+    std::vector< byte_range > merged;
+    std::atomic< bool > done;
+    std::thread prefetcher;
+};
+
 /*
  * TODO: account for padding
  */
-template< typename Stream >
-std::pair< int, bookmark > tag( basic_file< Stream >& fs, int remaining ) {
+template< typename File >
+std::pair< int, bookmark > tag( File& fs, int remaining ) {
     bookmark mark;
     mark.residual = remaining;
     mark.tell = fs.tell();
@@ -231,13 +811,13 @@ std::pair< int, bookmark > tag( basic_file< Stream >& fs, int remaining ) {
      * so bundle it up and automate it
      */
     struct Cursor {
-        basic_file< Stream >& fs;
+        File& fs;
         int remaining;
         segheader seg;
         int strlen = 0;
         bool has_successor = false;
 
-        Cursor( basic_file< Stream >& f, int rem ) :
+        Cursor( File& f, int rem ) :
             fs( f ), remaining( rem )
         {}
 
@@ -291,6 +871,7 @@ std::pair< int, bookmark > tag( basic_file< Stream >& fs, int remaining ) {
 
     mark.isexplicit  = cursor.seg.attrs & DLIS_SEGATTR_EXFMTLR;
     mark.isencrypted = cursor.seg.attrs & DLIS_SEGATTR_ENCRYPT;
+    mark.type        = cursor.seg.type;
 
     /*
      * if explicit, callers can consider to either read it now, or manually
@@ -370,6 +951,163 @@ std::pair< int, bookmark > tag( basic_file< Stream >& fs, int remaining ) {
     return { cursor.remaining, mark };
 }
 
+/*
+ * Statistics from parallel_index, mostly useful for tuning and debugging.
+ *
+ * ranges is the number of byte ranges the file was split into. resolved is
+ * the number of range boundaries where the visible record chain found by
+ * scanning the range disagreed with the chain walked from the start of the
+ * file, and had to be re-walked. fallbacks is the number of records with an
+ * object name split across segments, which are re-read with tag().
+ *
+ * truncated is the position of the first record that extends past the end
+ * of the file, i.e. where scan_record would return DLIS_TRUNCATED, or -1 if
+ * the file is complete.
+ */
+struct index_report {
+    int ranges = 0;
+    int resolved = 0;
+    int fallbacks = 0;
+    std::int64_t truncated = -1;
+};
+
+/*
+ * Build the bookmarks for all records in [begin, eof), like calling tag()
+ * repeatedly from begin with remaining = 0, but split over multiple threads.
+ * begin must be the position of a visible record label, usually right after
+ * the storage unit label.
+ *
+ * The file is split into byte ranges, and the visible record labels in each
+ * range are found concurrently. The per-range results are then stitched
+ * together, and the records in the visible records are tagged concurrently.
+ * The output is identical to that of the sequential scan.
+ *
+ * A truncated file is indexed like scan_record does, i.e. the records that
+ * are complete are kept, and the incomplete record at the end is dropped.
+ * The file is left at the incomplete record, and its position is reported
+ * in index_report::truncated.
+ *
+ * If threads is 0, one thread per core is used. If the vrl_table is not
+ * null, it is filled with the visible records found.
+ */
+std::vector< bookmark > parallel_index( mapped_file&,
+                                        std::streamsize begin,
+                                        int threads,
+                                        index_report* = nullptr,
+                                        vrl_table* = nullptr )
+noexcept (false);
+
+/*
+ * The bookmarks of a file, stored column-wise.
+ *
+ * A file can have millions of records, most of them implicit records that
+ * share a handful of object names. Rather than a bookmark (with its own copy
+ * of the name) per record, every name is stored once in names, and records
+ * refer to their name by its position. Explicit and encrypted records have
+ * no name, and nameid -1.
+ *
+ * The columns are plain arrays, so that they can be handed out to python
+ * as numpy arrays without copying.
+ */
+struct record_index {
+    enum flag : std::uint8_t {
+        explicit_record  = 1 << 0,
+        encrypted_record = 1 << 1,
+    };
+
+    std::vector< std::int64_t > tells;
+    std::vector< std::int32_t > residuals;
+    std::vector< std::uint8_t > flags;
+    std::vector< std::uint8_t > types;
+    std::vector< std::int32_t > nameids;
+    std::vector< obname > names;
+
+    std::size_t size() const noexcept (true);
+
+    /* re-create the bookmark of record i */
+    bookmark operator [] ( std::size_t i ) const noexcept (false);
+
+    /* append a record, and intern its name */
+    void push_back( const bookmark& ) noexcept (false);
+
+    /*
+     * Get the id of name, and add it to the names if it's not already
+     * there
+     */
+    std::int32_t intern( const obname& ) noexcept (false);
+
+private:
+    using key = std::tuple< std::int32_t, std::uint8_t, std::string >;
+    std::map< key, std::int32_t > interned;
+};
+
+/*
+ * The index of a file, i.e. the bookmarks of all records, the positions (in
+ * records) of the explicit records, and the positions of the implicit records
+ * grouped by object name, so that implicits[k] are the records named
+ * records.names[k].
+ *
+ * Building it requires a full scan of the file, so it can be stored in a
+ * sidecar file with write_index, and loaded later with read_index.
+ */
+struct file_index {
+    record_index records;
+    vrl_table vrls;
+    std::vector< std::size_t > explicits;
+    std::vector< std::vector< std::size_t > > implicits;
+};
+
+file_index make_index( record_index ) noexcept (false);
+file_index make_index( std::vector< bookmark > ) noexcept (false);
+
+/*
+ * Parse the explicit records at positions (in records) into object sets,
+ * spread over threads threads. Once indexed, the records are independent, so
+ * they are fetched with a record_batch, and viewed and parsed concurrently.
+ * If threads is 0, one thread per core is used.
+ *
+ * The sets are in the same order as positions, and encrypted records get an
+ * empty set. If errors is null, the first record (in positions order) that
+ * fails to parse is re-thrown. Otherwise errors is resized to positions, the
+ * exceptions are stored there, and the failed records get an empty set.
+ */
+std::vector< object_set > parse_eflrs( mapped_file&,
+                                       const record_index&,
+                                       const std::vector< std::size_t >& positions,
+                                       int threads,
+                                       std::vector< std::exception_ptr >* errors
+                                            = nullptr )
+noexcept (false);
+
+/* Parse all the explicit records of the file, in file order */
+std::vector< object_set > parse_eflrs( mapped_file&,
+                                       const file_index&,
+                                       int threads )
+noexcept (false);
+
+/*
+ * Write the index of the file at dlispath to path. The size and modification
+ * time (with sub-second precision) of the dlis file is recorded, so that
+ * read_index can tell if the index is stale. The index is written to a
+ * temporary file next to path and renamed over it, so path is either the old
+ * or the new index, never a partial one. Throws std::runtime_error if the
+ * index cannot be written.
+ */
+void write_index( const std::string& path,
+                  const std::string& dlispath,
+                  const file_index& )
+noexcept (false);
+
+/*
+ * Read the index at path into out. Returns false, and leaves out untouched, if
+ * the index does not exist, is not a dlisio index, or does not match the size
+ * and modification time of the file at dlispath.
+ */
+bool read_index( const std::string& path,
+                 const std::string& dlispath,
+                 file_index& out )
+noexcept (false);
+
 }
 
 #endif // DLISIO_PYTHON_IO_HPP
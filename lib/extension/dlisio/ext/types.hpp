@@ -2,9 +2,14 @@
 #define DLISIO_EXT_TYPES_HPP
 
 #include <complex>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -234,51 +239,143 @@ template<> struct typeinfo< dl::units > {
     static const representation_code reprc = dl::representation_code::units;
 };
 
+/*
+ * The inverse of typeinfo, i.e. the type for a representation code.
+ *
+ * visit_reprc does the runtime -> compile time translation in one place: it
+ * calls vis.operator()< T >() with the type matching the representation code,
+ * so the switch is done once per run of values, and the loop over the values
+ * is specialised for T. The visitor must define result_type, like a
+ * boost::static_visitor.
+ */
+template< representation_code > struct reprc_type;
+
+#define DLIS_REGISTER_REPRC(name) \
+    template<> struct reprc_type< representation_code::name > { \
+        using type = dl::name; \
+        static_assert( typeinfo< type >::reprc == representation_code::name, \
+                       "typeinfo and reprc_type must agree" ); \
+    };
+
+DLIS_REGISTER_REPRC(fshort)
+DLIS_REGISTER_REPRC(fsingl)
+DLIS_REGISTER_REPRC(fsing1)
+DLIS_REGISTER_REPRC(fsing2)
+DLIS_REGISTER_REPRC(isingl)
+DLIS_REGISTER_REPRC(vsingl)
+DLIS_REGISTER_REPRC(fdoubl)
+DLIS_REGISTER_REPRC(fdoub1)
+DLIS_REGISTER_REPRC(fdoub2)
+DLIS_REGISTER_REPRC(csingl)
+DLIS_REGISTER_REPRC(cdoubl)
+DLIS_REGISTER_REPRC(sshort)
+DLIS_REGISTER_REPRC(snorm)
+DLIS_REGISTER_REPRC(slong)
+DLIS_REGISTER_REPRC(ushort)
+DLIS_REGISTER_REPRC(unorm)
+DLIS_REGISTER_REPRC(ulong)
+DLIS_REGISTER_REPRC(uvari)
+DLIS_REGISTER_REPRC(ident)
+DLIS_REGISTER_REPRC(ascii)
+DLIS_REGISTER_REPRC(dtime)
+DLIS_REGISTER_REPRC(origin)
+DLIS_REGISTER_REPRC(obname)
+DLIS_REGISTER_REPRC(objref)
+DLIS_REGISTER_REPRC(attref)
+DLIS_REGISTER_REPRC(status)
+DLIS_REGISTER_REPRC(units)
+
+#undef DLIS_REGISTER_REPRC
+
+template< typename Visitor >
+typename Visitor::result_type
+visit_reprc( representation_code reprc, Visitor& vis ) noexcept (false) {
+    using rep = representation_code;
+    switch (reprc) {
+        case rep::fshort: return vis.template operator()< reprc_type< rep::fshort >::type >();
+        case rep::fsingl: return vis.template operator()< reprc_type< rep::fsingl >::type >();
+        case rep::fsing1: return vis.template operator()< reprc_type< rep::fsing1 >::type >();
+        case rep::fsing2: return vis.template operator()< reprc_type< rep::fsing2 >::type >();
+        case rep::isingl: return vis.template operator()< reprc_type< rep::isingl >::type >();
+        case rep::vsingl: return vis.template operator()< reprc_type< rep::vsingl >::type >();
+        case rep::fdoubl: return vis.template operator()< reprc_type< rep::fdoubl >::type >();
+        case rep::fdoub1: return vis.template operator()< reprc_type< rep::fdoub1 >::type >();
+        case rep::fdoub2: return vis.template operator()< reprc_type< rep::fdoub2 >::type >();
+        case rep::csingl: return vis.template operator()< reprc_type< rep::csingl >::type >();
+        case rep::cdoubl: return vis.template operator()< reprc_type< rep::cdoubl >::type >();
+        case rep::sshort: return vis.template operator()< reprc_type< rep::sshort >::type >();
+        case rep::snorm : return vis.template operator()< reprc_type< rep::snorm  >::type >();
+        case rep::slong : return vis.template operator()< reprc_type< rep::slong  >::type >();
+        case rep::ushort: return vis.template operator()< reprc_type< rep::ushort >::type >();
+        case rep::unorm : return vis.template operator()< reprc_type< rep::unorm  >::type >();
+        case rep::ulong : return vis.template operator()< reprc_type< rep::ulong  >::type >();
+        case rep::uvari : return vis.template operator()< reprc_type< rep::uvari  >::type >();
+        case rep::ident : return vis.template operator()< reprc_type< rep::ident  >::type >();
+        case rep::ascii : return vis.template operator()< reprc_type< rep::ascii  >::type >();
+        case rep::dtime : return vis.template operator()< reprc_type< rep::dtime  >::type >();
+        case rep::origin: return vis.template operator()< reprc_type< rep::origin >::type >();
+        case rep::obname: return vis.template operator()< reprc_type< rep::obname >::type >();
+        case rep::objref: return vis.template operator()< reprc_type< rep::objref >::type >();
+        case rep::attref: return vis.template operator()< reprc_type< rep::attref >::type >();
+        case rep::status: return vis.template operator()< reprc_type< rep::status >::type >();
+        case rep::units : return vis.template operator()< reprc_type< rep::units  >::type >();
+    }
+
+    const auto msg = "unknown representation code "
+                   + std::to_string( static_cast< int >( reprc ) )
+                   ;
+    throw std::invalid_argument( msg );
+}
+
 /*
  * Parsing and parsing input
  *
  * the strategy is to first parse the EFLR template and build a parsing guide,
  * expressed as the object_template. Later, this template instantiates the
  * default object in the set, and edits the fields as it goes along. The value
- * field can be zero or more values, so it's neatly stored as a vector, but the
- * *type* is indeterminate until the representation code is understood.
+ * field can be zero or more values, but the *type* is indeterminate until the
+ * representation code is understood.
  *
- * The variant is a perfect fit for this.
+ * Most attribute values are never looked at, so the values are not decoded
+ * when the record is parsed. The value_vector only records the representation
+ * code, the count, and where the values are in the record, which is a few
+ * words per attribute, and the values are decoded on typed access with get().
  *
- * A variant-of-vector seems a better fit than vector-of-variants, both because
- * the max-size-overhead isn't so bad (all vectors are the same size), but the
- * type-resolution only has to be done once, and the unstructuring of the
- * vector can be contained inside the visitor.
+ * The value_vector does not own the bytes it points to, which must outlive
+ * it. parse_eflr copies the record into the object set for this reason.
  */
-using value_vector = boost::variant<
-    std::vector< fshort >,
-    std::vector< fsingl >,
-    std::vector< fsing1 >,
-    std::vector< fsing2 >,
-    std::vector< isingl >,
-    std::vector< vsingl >,
-    std::vector< fdoubl >,
-    std::vector< fdoub1 >,
-    std::vector< fdoub2 >,
-    std::vector< csingl >,
-    std::vector< cdoubl >,
-    std::vector< sshort >,
-    std::vector< snorm  >,
-    std::vector< slong  >,
-    std::vector< ushort >,
-    std::vector< unorm  >,
-    std::vector< ulong  >,
-    std::vector< uvari  >,
-    std::vector< ident  >,
-    std::vector< ascii  >,
-    std::vector< dtime  >,
-    std::vector< origin >,
-    std::vector< obname >,
-    std::vector< objref >,
-    std::vector< attref >,
-    std::vector< status >,
-    std::vector< units  >
->;
+class value_vector {
+public:
+    value_vector() = default;
+    value_vector( representation_code reprc,
+                  std::int32_t count,
+                  const char* begin,
+                  const char* end ) noexcept (true);
+
+    representation_code reprc() const noexcept (true);
+    std::size_t size() const noexcept (true);
+    bool empty() const noexcept (true);
+
+    /* the raw, undecoded values */
+    const char* data() const noexcept (true);
+    std::size_t bytes() const noexcept (true);
+
+    /*
+     * Decode the values into out. Throws invalid_argument if T does not match
+     * the representation code
+     */
+    template < typename T >
+    void get( std::vector< T >& out ) const noexcept (false);
+
+    template < typename T >
+    std::vector< T > get() const noexcept (false);
+
+private:
+    const char* begin = nullptr;
+    std::uint32_t len = 0;
+    std::int32_t count = 0;
+    representation_code code = representation_code::fshort;
+};
 
 /*
  * The structure of an attribute as described in 3.2.2.1
@@ -320,6 +417,18 @@ struct basic_object {
     void set_name( std::string ) noexcept (false);
 };
 
+/*
+ * Attributes stored as-is, in what is essentially a dictionary. set() inserts
+ * the attribute, or replaces the one with the same label.
+ */
+struct attribute_list {
+    std::vector< object_attribute > attributes;
+    /* where set() starts looking for the label */
+    std::size_t hint = 0;
+
+    void set( const object_attribute& ) noexcept (false);
+};
+
 /*
  * All objects should have a method set, that checks a property against the
  * labels defined by the standard, and sets the right member variable. It must
@@ -341,8 +450,11 @@ struct origin_object : basic_object {
     dl::ascii product;
     dl::ascii version;
     std::vector< dl::ascii > programs;
-    /* descent - run nr */
-    /* well-id */
+    dl::dtime creation_time;
+    dl::ascii order_number;
+    dl::value_vector descent_number;
+    dl::value_vector run_number;
+    dl::value_vector well_id;
     dl::ascii well_name;
     dl::ascii field_name;
     dl::unorm producer_code;
@@ -350,6 +462,7 @@ struct origin_object : basic_object {
     dl::ascii company;
     dl::ident namespace_name;
     dl::uvari namespace_version;
+    attribute_list unknown;
 
     origin_object&
     set( const object_attribute&, bool = false )
@@ -369,14 +482,79 @@ struct channel : basic_object {
     channel& set( const object_attribute&, bool = false ) noexcept (false);
 };
 
+/*
+ * The remaining typed objects of chapter 5. Attributes that the standard
+ * allows to be of any representation code are kept as value_vectors, which
+ * point into the record of the set, so these objects must not outlive the
+ * object_set they were parsed into.
+ *
+ * Vendors add their own attributes to these sets, so attributes with labels
+ * that are not in the standard are kept in unknown, rather than rejecting
+ * the set. origin_object does the same.
+ */
+struct frame : basic_object {
+    dl::ascii description;
+    std::vector< dl::obname > channels;
+    dl::ident index_type;
+    dl::ident direction;
+    dl::value_vector spacing;
+    dl::ushort encrypted = 0;
+    dl::value_vector index_min;
+    dl::value_vector index_max;
+    attribute_list unknown;
+
+    frame& set( const object_attribute&, bool = false ) noexcept (false);
+};
+
+struct axis : basic_object {
+    dl::ident axis_id;
+    dl::value_vector coordinates;
+    dl::value_vector spacing;
+    attribute_list unknown;
+
+    axis& set( const object_attribute&, bool = false ) noexcept (false);
+};
+
+struct parameter : basic_object {
+    boost::variant< dl::obname, dl::ascii > name;
+    std::vector< dl::uvari > dimension;
+    std::vector< dl::obname > axis;
+    std::vector< dl::obname > zones;
+    dl::value_vector values;
+    attribute_list unknown;
+
+    parameter& set( const object_attribute&, bool = false ) noexcept (false);
+};
+
+struct zone : basic_object {
+    dl::ascii description;
+    dl::ident domain;
+    dl::value_vector maximum;
+    dl::value_vector minimum;
+    attribute_list unknown;
+
+    zone& set( const object_attribute&, bool = false ) noexcept (false);
+};
+
+struct tool : basic_object {
+    dl::ascii description;
+    dl::ascii trademark_name;
+    dl::ascii generic_name;
+    std::vector< dl::obname > parts;
+    dl::status status = dl::status{ 0 };
+    std::vector< dl::obname > channels;
+    std::vector< dl::obname > parameters;
+    attribute_list unknown;
+
+    tool& set( const object_attribute&, bool = false ) noexcept (false);
+};
+
 /*
  * The fall-through object - RP66 opens for private or company specific
  * records, or otherwise broken entries, that we don't want to discard.
  * Instead, just store the attributes in what is essentially a dictionary
  */
-struct unknown_object : basic_object {
-    std::vector< object_attribute > attributes;
-
+struct unknown_object : basic_object, attribute_list {
     unknown_object&
     set( const object_attribute&, bool = false )
     noexcept (false);
@@ -393,10 +571,20 @@ using object_vector = boost::variant<
     std::vector< file_header >,
     std::vector< origin_object >,
     std::vector< channel >,
+    std::vector< frame >,
+    std::vector< axis >,
+    std::vector< parameter >,
+    std::vector< zone >,
+    std::vector< tool >,
     std::vector< unknown_object >
 >;
 
 struct object_set {
+    /*
+     * The copy of the record the attribute values point into. It is shared
+     * between copies of the set
+     */
+    std::shared_ptr< const char > record;
     int role; // TODO: enum class?
     dl::ident type;
     dl::ident name;
@@ -404,27 +592,66 @@ struct object_set {
     dl::object_vector objects;
 };
 
+/*
+ * Parse the template. The attribute values point into [begin, end), which
+ * must outlive the template.
+ */
 const char* parse_template( const char* begin,
                             const char* end,
                             object_template& ) noexcept (false);
 
 
+/*
+ * Parse an EFLR into an object set. The record is copied into the set, so the
+ * input can be discarded after parsing.
+ */
 object_set parse_eflr( const char*, const char*, int ) noexcept (false);
 
+/*
+ * Find the channel objects of frames, by looking up the names in CHANNELS in
+ * all the CHANNEL sets. The index is built once, in a single pass over the
+ * sets, and holds pointers into them, so the sets must outlive it. If a name
+ * is in several sets, the first one is used.
+ */
+class channel_index {
+public:
+    explicit channel_index( const std::vector< object_set >& )
+    noexcept (false);
+
+    std::size_t size() const noexcept (true);
+
+    /* throws std::out_of_range if there is no channel with this name */
+    const channel& at( const obname& ) const noexcept (false);
+
+    /* the channels of the frame, in frame order */
+    std::vector< const channel* > resolve( const frame& ) const
+    noexcept (false);
+
+private:
+    struct hash {
+        std::size_t operator()( const obname& ) const noexcept (true);
+    };
+
+    std::unordered_map< obname, const channel*, hash > channels;
+};
+
 /*
  * implementations
  */
 template < typename T >
-void object_attribute::into( T& x, bool allow_empty ) const noexcept (false) {
-    // TODO: catch boost-get error,
-    // then re-throw as something suitable with a better message
-    // ?
-
-    if (this->reprc != dl::typeinfo< T >::reprc) {
-        throw std::invalid_argument( "mismatching reprc" );
-    }
+std::vector< T > value_vector::get() const noexcept (false) {
+    std::vector< T > out;
+    this->get( out );
+    return out;
+}
 
-    if (this->value.which() == 0 && allow_empty) {
+template < typename T >
+void object_attribute::into( T& x, bool allow_empty ) const noexcept (false) {
+    /*
+     * The reprc of an attribute without a value is only the default from the
+     * template, which often does not specify any, so it's not checked
+     */
+    if (this->value.empty() && allow_empty) {
         /*
          * set to default-constructed of correct type
          *
@@ -436,15 +663,23 @@ void object_attribute::into( T& x, bool allow_empty ) const noexcept (false) {
         return;
     }
 
+    if (this->reprc != dl::typeinfo< T >::reprc) {
+        throw std::invalid_argument( "mismatching reprc" );
+    }
+
     // TODO: if count > 1, fail with warning?
-    using Vec = std::vector< T >;
-    x = boost::get< Vec >( this->value ).front();
+    const auto xs = this->value.get< T >();
+    if (xs.empty())
+        throw std::invalid_argument( "attribute has no value" );
+
+    x = xs.front();
 }
 
 template <>
-void object_attribute::into( dl::representation_code& x, bool allow_empty )
+inline void object_attribute::into( dl::representation_code& x,
+                                    bool allow_empty )
 const noexcept (false) {
-    if (this->value.which() == 0 && allow_empty)
+    if (this->value.empty() && allow_empty)
         return;
 
     dl::ushort tmp;
@@ -452,22 +687,30 @@ const noexcept (false) {
     x = static_cast< dl::representation_code >( tmp );
 }
 
+/*
+ * Attributes of any representation code are stored as-is, to be decoded by
+ * whoever knows what to expect
+ */
+template <>
+inline void object_attribute::into( dl::value_vector& x, bool )
+const noexcept (false) {
+    x = this->value;
+}
+
 template < typename T >
 void object_attribute::into( std::vector< T >& v, bool allow_empty )
 const noexcept (false)
 {
-    // TODO: catch boost-get error,
-    // then re-throw as something suitable with a better message
-    if (this->reprc != dl::typeinfo< T >::reprc) {
-        throw std::invalid_argument( "mismatching reprc" );
+    if (this->value.empty() && allow_empty) {
+        v.clear();
+        return;
     }
 
-    if (this->value.which() == 0 && allow_empty) {
-        return;
+    if (this->reprc != dl::typeinfo< T >::reprc) {
+        throw std::invalid_argument( "mismatching reprc" );
     }
 
-    using Vec = std::vector< T >;
-    v = boost::get< Vec >( this->value );
+    this->value.get( v );
 }
 
 }
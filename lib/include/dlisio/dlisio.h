@@ -183,6 +183,10 @@ enum DLIS_ERRCODE {
     DLIS_OK = 0,
     DLIS_INCONSISTENT,
     DLIS_UNEXPECTED_VALUE,
+    /* a header or record extends past the end of the file */
+    DLIS_TRUNCATED,
+    /* clean end-of-file, i.e. nothing more to read */
+    DLIS_EOF,
 };
 
 enum dlis_eflr_type_code {
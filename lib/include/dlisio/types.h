@@ -1,6 +1,7 @@
 #ifndef DLISIO_TYPES_H
 #define DLISIO_TYPES_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -92,6 +93,95 @@ const char* dlis_attref( const char*, int32_t* ident1_len,
 const char* dlis_status( const char*, uint8_t* );
 const char* dlis_units( const char*, int32_t*, char* );
 
+/*
+ * Bulk variants of the fixed-size parsers. Decode n consecutive values into
+ * the output array, and return a pointer to the first character NOT consumed,
+ * i.e. xs + n * sizeof(value).
+ *
+ * The byteswap is done over the whole buffer at once, with the widest SIMD
+ * shuffle supported by the running CPU, and the results are identical to
+ * calling the scalar function n times. The input needs no alignment, and must
+ * not overlap the output.
+ */
+const char* dlis_sshort_n( const char*, size_t n, int8_t* );
+const char* dlis_snorm_n(  const char*, size_t n, int16_t* );
+const char* dlis_slong_n(  const char*, size_t n, int32_t* );
+
+const char* dlis_ushort_n( const char*, size_t n, uint8_t* );
+const char* dlis_unorm_n(  const char*, size_t n, uint16_t* );
+const char* dlis_ulong_n(  const char*, size_t n, uint32_t* );
+
+const char* dlis_fsingl_n( const char*, size_t n, float* );
+const char* dlis_fdoubl_n( const char*, size_t n, double* );
+
+/* FSHORT, IBM and VAX floats, converted to IEEE several lanes at a time */
+const char* dlis_fshort_n( const char*, size_t n, float* );
+const char* dlis_isingl_n( const char*, size_t n, float* );
+const char* dlis_vsingl_n( const char*, size_t n, float* );
+
+/*
+ * Decode one channel from a run of fixed-size frames. Frames are stride bytes
+ * apart, starting at base, and the channel is count values of type reprc at
+ * offset bytes into every frame. The nframes * count values are written
+ * contiguously to out, as the same native type as the scalar parser, i.e.
+ * float for FSHORT, float[2] for FSING1 and CSINGL, int16_t for SNORM.
+ *
+ * This is the same as calling the scalar parser on every value, but the
+ * channel bytes are gathered into blocks and decoded with the bulk functions.
+ *
+ * Returns 0 on success, and a negative value if reprc is not a fixed-size
+ * numerical type.
+ */
+int dlis_decode_strided( int reprc,
+                         const char* base,
+                         size_t stride,
+                         size_t offset,
+                         size_t count,
+                         size_t nframes,
+                         void* out );
+
+/*
+ * Skip n values of type reprc, without decoding them. Variable-length values
+ * only have their length prefixes read, so no strings are copied or built.
+ *
+ * Returns a pointer to the first character after the n values, or NULL if
+ * reprc is not a valid representation code.
+ */
+const char* dlis_skip( int reprc, const char* xs, size_t n );
+
+/*
+ * Skip n values of type reprc like dlis_skip, but without reading at or past
+ * end, so that values with bogus lengths in malformed records are caught
+ * rather than read out of bounds.
+ *
+ * Returns a pointer to the first character after the n values, which is at
+ * most end, or NULL if reprc is not a valid representation code or the
+ * values do not fit in [xs, end).
+ */
+const char* dlis_skip_bounded( int reprc,
+                               const char* xs,
+                               const char* end,
+                               size_t n );
+
+/*
+ * Find the byte offsets of all channels in a frame [xs, end) in one pass. The
+ * frame layout is given as nchannels (count, reprc) pairs. offsets[i] is set
+ * to the start of channel i relative to xs, and offsets[nchannels] to the
+ * size of the frame, so offsets must have room for nchannels + 1 elements.
+ * Fixed-size channels are skipped without reading xs, and variable-size
+ * channels only have their lengths read. Nothing at or past end is read.
+ *
+ * Returns DLIS_OK on success, DLIS_UNEXPECTED_VALUE on an invalid
+ * representation code or a negative count, and DLIS_TRUNCATED if the
+ * channels do not fit in [xs, end).
+ */
+int dlis_frame_offsets( const char* xs,
+                        const char* end,
+                        size_t nchannels,
+                        const int32_t* counts,
+                        const int32_t* reprcs,
+                        size_t* offsets );
+
 /*
  * A family of the reverse operation, i.e. transform a native data type to an
  * RP66 compatible one.
@@ -0,0 +1,958 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <dlisio/dlisio.h>
+#include <dlisio/types.h>
+#include <dlisio/ext/io.hpp>
+
+#include "parallel.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define HAVE_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define HAVE_SSE2 0
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace dl {
+
+namespace {
+
+#if HAVE_SSE2
+int count_trailing_zeros( int mask ) noexcept (true) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward( &index, mask );
+    return int( index );
+#else
+    return __builtin_ctz( mask );
+#endif
+}
+#endif
+
+int visible_record_length( const char* xs ) noexcept (true) {
+    int len, version;
+    dlis_vrl( xs, &len, &version );
+    return len;
+}
+
+/*
+ * Check if there is something that looks like a visible record label at pos,
+ * i.e. the padding and version bytes are 0xFF 0x01, the record fits in the
+ * file, and it starts with a logical record segment header that fits in the
+ * visible record.
+ *
+ * This is used for finding a place to start in the middle of a file, and
+ * there might be false positives.
+ */
+bool plausible_vrl( const char* data, std::int64_t pos, std::int64_t size )
+noexcept (true) {
+    if (pos + DLIS_VRL_SIZE + DLIS_LRSH_SIZE > size) return false;
+
+    const auto* xs = data + pos;
+    if (std::uint8_t( xs[ 2 ] ) != 0xFF || xs[ 3 ] != 1) return false;
+
+    const auto len = visible_record_length( xs );
+    if (len < DLIS_VRL_SIZE + DLIS_LRSH_SIZE) return false;
+    if (pos + len > size) return false;
+
+    int seglen, type;
+    std::uint8_t attrs;
+    dlis_lrsh( xs + DLIS_VRL_SIZE, &seglen, &attrs, &type );
+    return seglen >= DLIS_LRSH_SIZE && seglen <= len - DLIS_VRL_SIZE;
+}
+
+struct vrl_chain {
+    /* positions of the visible record labels, all in [lo, hi) */
+    std::vector< std::int64_t > labels;
+    /* first position >= hi, where the next range picks up */
+    std::int64_t exit = -1;
+};
+
+/*
+ * Find the first position >= from that could be a visible record label, i.e.
+ * where the padding and version bytes (at offset 2 and 3) are 0xFF 0x01.
+ * Returns -1 if there is none.
+ */
+std::int64_t find_vrl( const char* data, std::int64_t size, std::int64_t from )
+noexcept (true) {
+    auto i = from + 2;
+
+#if HAVE_SSE2
+    /*
+     * compare 16 positions at a time, for both the padding byte and the
+     * version byte in the next position
+     */
+    const auto pad     = _mm_set1_epi8( char( 0xFF ) );
+    const auto version = _mm_set1_epi8( 1 );
+    for (; i + 17 <= size; i += 16) {
+        const auto* xs = data + i;
+        const auto a = _mm_loadu_si128( reinterpret_cast< const __m128i* >( xs ) );
+        const auto b = _mm_loadu_si128( reinterpret_cast< const __m128i* >( xs + 1 ) );
+        const auto hits = _mm_and_si128( _mm_cmpeq_epi8( a, pad ),
+                                         _mm_cmpeq_epi8( b, version ) );
+        const auto mask = _mm_movemask_epi8( hits );
+        if (mask) return i + count_trailing_zeros( mask ) - 2;
+    }
+#endif
+
+    while (i + 1 < size) {
+        const auto* found = static_cast< const char* >(
+            std::memchr( data + i, 0xFF, size - i - 1 )
+        );
+
+        if (!found) return -1;
+        i = std::distance( data, found );
+        if (data[ i + 1 ] == 1) return i - 2;
+        ++i;
+    }
+
+    return -1;
+}
+
+/*
+ * Speculatively find the chain of visible records in [lo, hi). The chain
+ * starts at the first plausible visible record label for which every
+ * following label, until hi, is also plausible.
+ */
+vrl_chain scan_range( const char* data,
+                      std::int64_t size,
+                      std::int64_t lo,
+                      std::int64_t hi ) noexcept (false) {
+    vrl_chain chain;
+
+    auto from = lo;
+    while (from < hi) {
+        const auto start = find_vrl( data, size, from );
+        if (start < 0 || start >= hi) break;
+        from = start + 1;
+
+        chain.labels.clear();
+        auto pos = start;
+        while (pos < hi && plausible_vrl( data, pos, size )) {
+            chain.labels.push_back( pos );
+            pos += visible_record_length( data + pos );
+        }
+
+        if (pos >= hi && !chain.labels.empty()) {
+            chain.exit = pos;
+            return chain;
+        }
+    }
+
+    chain.labels.clear();
+    return chain;
+}
+
+/*
+ * Walk the chain of visible records from pos, which is known to be a visible
+ * record label, and stop at the first label >= hi. A label cut off by the end
+ * of the file is not a part of the chain, and the walk stops there, so that
+ * the returned position is < hi when the file is truncated.
+ */
+std::int64_t walk_range( const char* data,
+                         std::int64_t size,
+                         std::int64_t pos,
+                         std::int64_t hi,
+                         std::vector< std::int64_t >& labels )
+noexcept (false) {
+    while (pos < hi) {
+        if (pos + DLIS_VRL_SIZE > size) break;
+
+        const auto len = visible_record_length( data + pos );
+        if (len < DLIS_VRL_SIZE) {
+            const auto msg = "visible record length < "
+                           + std::to_string( DLIS_VRL_SIZE ) + " (was "
+                           + std::to_string( len ) + ") at "
+                           + std::to_string( pos )
+                           ;
+            throw std::runtime_error( msg );
+        }
+
+        labels.push_back( pos );
+        pos += len;
+    }
+
+    return pos;
+}
+
+struct segment {
+    std::int64_t pos;
+    std::int64_t vrl;
+    std::int64_t vrend;
+    std::uint8_t attrs;
+    int type;
+    bool named = false;
+    /* the segment header or body is cut off by the end of the file */
+    bool truncated = false;
+    dl::obname name;
+};
+
+/*
+ * The position a record starting at this segment is bookmarked with, i.e.
+ * the visible record label if the segment is the first in the visible record
+ */
+std::int64_t record_tell( const segment& seg ) noexcept (true) {
+    if (seg.pos == seg.vrl + DLIS_VRL_SIZE) return seg.vrl;
+    return seg.pos;
+}
+
+/*
+ * Parse the object name of the segment, if this segment could be the start
+ * of an implicit record, and the object name fits in this segment. Otherwise,
+ * the segment is left unnamed, and if it turns out to be the start of a
+ * record, it's re-read with tag()
+ */
+void name_segment( const char* data, std::int64_t size, segment& seg )
+noexcept (false) {
+    constexpr auto unnamed = DLIS_SEGATTR_PREDSEG
+                           | DLIS_SEGATTR_EXFMTLR
+                           | DLIS_SEGATTR_ENCRYPT
+                           ;
+    if (seg.attrs & unnamed) return;
+
+    int seglen, type;
+    std::uint8_t attrs;
+    dlis_lrsh( data + seg.pos, &seglen, &attrs, &type );
+
+    /*
+     * tag() always reads 12 bytes of the body up front, so require that too,
+     * in order to fail the same way near end-of-file
+     */
+    const auto body = seg.pos + DLIS_LRSH_SIZE;
+    const auto end = seg.pos + seglen;
+    if (body + 12 > size) return;
+    if (end > size) return;
+
+    const auto* xs = data + body;
+    std::int32_t origin;
+    std::uint8_t copy;
+    std::uint8_t namelen;
+    xs = dlis_uvari( xs, &origin );
+    xs = dlis_ushort( xs, &copy );
+    xs = dlis_ushort( xs, &namelen );
+
+    if (std::distance( data, xs ) + namelen > end) return;
+
+    seg.name.origin = dl::origin{ origin };
+    seg.name.copy = copy;
+    seg.name.id = dl::ident{ std::string{ xs, xs + namelen } };
+    seg.named = true;
+}
+
+/*
+ * Find all logical record segments in the visible records [first, last).
+ *
+ * Only the last visible record of a truncated file can extend past the end
+ * of the file. The first segment in it that is cut off is added with the
+ * truncated flag, and nothing after it.
+ */
+std::vector< segment > segments( const char* data,
+                                 std::int64_t size,
+                                 const std::vector< std::int64_t >& labels,
+                                 std::size_t first,
+                                 std::size_t last )
+noexcept (false) {
+    std::vector< segment > segs;
+
+    for (auto i = first; i < last; ++i) {
+        const auto vrl = labels[ i ];
+        const auto vrend = vrl + visible_record_length( data + vrl );
+
+        auto pos = vrl + DLIS_VRL_SIZE;
+        while (pos < vrend) {
+            segment seg;
+            seg.pos = pos;
+            seg.vrl = vrl;
+            seg.vrend = vrend;
+
+            if (pos + DLIS_LRSH_SIZE > size) {
+                seg.truncated = true;
+                segs.push_back( std::move( seg ) );
+                return segs;
+            }
+
+            int seglen, type;
+            std::uint8_t attrs;
+            dlis_lrsh( data + pos, &seglen, &attrs, &type );
+
+            if (seglen < DLIS_LRSH_SIZE || pos + seglen > vrend) {
+                const auto msg = "seg.len > vrl.len ("
+                               + std::to_string( seglen )
+                               + " > "
+                               + std::to_string( vrend - pos )
+                               + ")"
+                               + " at " + std::to_string( pos )
+                               ;
+                throw std::runtime_error( msg );
+            }
+
+            seg.attrs = attrs;
+            seg.type = type;
+
+            if (pos + seglen > size) {
+                seg.truncated = true;
+                segs.push_back( std::move( seg ) );
+                return segs;
+            }
+
+            name_segment( data, size, seg );
+            segs.push_back( std::move( seg ) );
+
+            pos += seglen;
+        }
+    }
+
+    return segs;
+}
+
+
+/*
+ * The sidecar index format, all integers little endian:
+ *
+ *  magic       8 bytes, "DLISIDX" + version
+ *  size        int64, size of the dlis file
+ *  mtime       int64, modification time of the dlis file in nanoseconds
+ *  nnames      uint32, number of names, followed by nnames of:
+ *      origin      int32
+ *      copy        uint8
+ *      idlen       uint32, followed by idlen bytes of the name
+ *  count       uint32, number of records, followed by the columns:
+ *      tells       count int64
+ *      residuals   count int32
+ *      flags       count uint8
+ *      types       count uint8
+ *      nameids     count int32
+ *  nvrls       uint32, number of visible records, followed by the columns:
+ *      offsets     nvrls int64
+ *      lengths     nvrls int32
+ *
+ * The explicits and the grouping of implicits are cheap to re-create from
+ * the flags and nameids, so they are not stored.
+ *
+ * The mtime is only compared for equality, so its epoch is whatever the
+ * platform uses. It has sub-second precision, so that a file rewritten
+ * to the same size in the same second still gets its index rebuilt.
+ */
+constexpr char index_magic[] = { 'D', 'L', 'I', 'S', 'I', 'D', 'X', 5 };
+
+struct file_stat {
+    std::int64_t size;
+    std::int64_t mtime;
+};
+
+bool stat_file( const std::string& path, file_stat& out ) noexcept (true) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA st;
+    if (!::GetFileAttributesExA( path.c_str(), GetFileExInfoStandard, &st ))
+        return false;
+
+    const auto high = std::uint64_t( st.nFileSizeHigh );
+    out.size = std::int64_t( (high << 32) | st.nFileSizeLow );
+    /* FILETIME counts 100-nanosecond intervals */
+    const auto& t = st.ftLastWriteTime;
+    const auto ticks = (std::uint64_t( t.dwHighDateTime ) << 32)
+                     | t.dwLowDateTime;
+    out.mtime = std::int64_t( ticks * 100 );
+#else
+    struct stat st;
+    if (::stat( path.c_str(), &st ) != 0) return false;
+
+    out.size = st.st_size;
+    #ifdef __APPLE__
+        const auto& t = st.st_mtimespec;
+    #else
+        const auto& t = st.st_mtim;
+    #endif
+    out.mtime = std::int64_t( t.tv_sec ) * 1000000000 + t.tv_nsec;
+#endif
+    return true;
+}
+
+/*
+ * A path next to the sidecar to write the index to before renaming it over
+ * the sidecar, so that readers, also in other processes, never see a
+ * partially written index. It is unique to this process and call, so that
+ * concurrent writers don't clobber each other's temporaries.
+ */
+std::string temp_path( const std::string& path ) noexcept (false) {
+    static std::atomic< unsigned > counter( 0 );
+#ifdef _WIN32
+    const auto pid = ::_getpid();
+#else
+    const auto pid = ::getpid();
+#endif
+    return path
+         + ".tmp-" + std::to_string( pid )
+         + "-" + std::to_string( counter++ )
+         ;
+}
+
+/*
+ * Replace the file at path with the one at tmp. std::rename replaces an
+ * existing file atomically on POSIX, but fails on windows, so use
+ * MoveFileEx there.
+ */
+bool replace_file( const std::string& tmp, const std::string& path )
+noexcept (true) {
+#ifdef _WIN32
+    return ::MoveFileExA( tmp.c_str(),
+                          path.c_str(),
+                          MOVEFILE_REPLACE_EXISTING );
+#else
+    return std::rename( tmp.c_str(), path.c_str() ) == 0;
+#endif
+}
+
+template< typename T >
+void put( std::vector< char >& out, T x ) noexcept (false) {
+    const auto u = static_cast< std::uint64_t >( x );
+    for (std::size_t i = 0; i < sizeof( T ); ++i)
+        out.push_back( char( (u >> (8 * i)) & 0xFF ) );
+}
+
+/*
+ * A bounds-checked reader over the index. Reading past the end does not
+ * throw, but marks the reader as bad, as a truncated index is merely invalid
+ */
+struct index_reader {
+    const char* cur;
+    const char* end;
+    bool bad = false;
+
+    index_reader( const char* first, const char* last ) :
+        cur( first ), end( last )
+    {}
+
+    template< typename T >
+    T get() noexcept (true) {
+        if (this->bad || std::size_t( this->end - this->cur ) < sizeof( T )) {
+            this->bad = true;
+            return T();
+        }
+
+        std::uint64_t u = 0;
+        for (std::size_t i = 0; i < sizeof( T ); ++i)
+            u |= std::uint64_t( std::uint8_t( this->cur[ i ] ) ) << (8 * i);
+        this->cur += sizeof( T );
+        return static_cast< T >( u );
+    }
+
+    std::string str( std::size_t n ) noexcept (false) {
+        if (this->bad || std::size_t( this->end - this->cur ) < n) {
+            this->bad = true;
+            return std::string();
+        }
+
+        std::string s( this->cur, this->cur + n );
+        this->cur += n;
+        return s;
+    }
+};
+
+}
+
+std::vector< bookmark > parallel_index( mapped_file& file,
+                                        std::streamsize begin,
+                                        int threads,
+                                        index_report* report,
+                                        vrl_table* vrls ) {
+    if (threads < 0)
+        throw std::invalid_argument( "threads must be non-negative" );
+
+    if (threads == 0)
+        threads = std::max( 1u, std::thread::hardware_concurrency() );
+
+    const auto* data = file.data();
+    const std::int64_t size = file.size();
+
+    index_report stats;
+    if (!report) report = &stats;
+    *report = index_report();
+
+    /*
+     * Find the visible records. The first range starts at a known label, so
+     * can be walked directly, the rest are scanned speculatively.
+     */
+    const auto ranges = static_cast< int >( std::max< std::int64_t >(
+        1, std::min< std::int64_t >( threads, size - begin )
+    ));
+    const auto rangesize = (size - begin) / ranges;
+    report->ranges = ranges;
+
+    std::vector< vrl_chain > chains( ranges );
+    parallel_for( ranges, threads, [&]( int i ) {
+        const auto lo = begin + i * rangesize;
+        const auto hi = i == ranges - 1 ? size : lo + rangesize;
+
+        if (i == 0)
+            chains[ i ].exit = walk_range( data, size, lo, hi,
+                                           chains[ i ].labels );
+        else
+            chains[ i ] = scan_range( data, size, lo, hi );
+    });
+
+    /*
+     * Stitch the chains together. The true chain from the previous range
+     * ends at some label in this range, and if the speculative chain agrees,
+     * it is correct from that label on. Otherwise, resolve it by walking it
+     * from the label.
+     */
+    std::vector< std::int64_t > labels = std::move( chains.front().labels );
+    auto exit = chains.front().exit;
+    for (int i = 1; i < ranges; ++i) {
+        const auto hi = i == ranges - 1 ? size : begin + (i + 1) * rangesize;
+        if (exit >= hi) continue;
+
+        const auto& chain = chains[ i ];
+        const auto itr = std::lower_bound( chain.labels.begin(),
+                                           chain.labels.end(),
+                                           exit );
+
+        if (itr != chain.labels.end() && *itr == exit) {
+            labels.insert( labels.end(), itr, chain.labels.end() );
+            exit = chain.exit;
+            continue;
+        }
+
+        report->resolved += 1;
+        exit = walk_range( data, size, exit, hi, labels );
+    }
+
+    /*
+     * Find and name the segments, in chunks of visible records. There are
+     * more chunks than threads, to even out differences in work.
+     */
+    const auto chunks = static_cast< int >( std::max< std::size_t >(
+        1, std::min< std::size_t >( labels.size(), 4 * threads )
+    ));
+    const auto chunksize = labels.size() / chunks;
+
+    std::vector< std::vector< segment > > segs( chunks );
+    parallel_for( chunks, threads, [&]( int i ) {
+        const auto first = i * chunksize;
+        const auto last = i == chunks - 1 ? labels.size() : first + chunksize;
+        segs[ i ] = segments( data, size, labels, first, last );
+    });
+
+    /*
+     * Finally, bookmark the records. A new record starts after every segment
+     * without a successor.
+     *
+     * If the file is truncated, the record that is cut off is dropped, like
+     * scan_record does. That is the record of the first truncated segment, or
+     * the last record if it still expects more segments at the end of the
+     * file. If the chain itself stopped at a label cut off by the end of the
+     * file, the complete records before it are kept.
+     */
+    std::vector< bookmark > marks;
+    /* implicit records with names split across segments */
+    std::vector< bool > unnamed;
+    std::int64_t truncated = exit < size ? exit : -1;
+    bool start = true;
+    bool cut = false;
+    for (auto& chunk : segs) {
+        for (auto& seg : chunk) {
+            if (seg.truncated) {
+                cut = true;
+                break;
+            }
+
+            const bool first = start;
+            start = !(seg.attrs & DLIS_SEGATTR_SUCCSEG);
+            if (!first) continue;
+
+            bookmark mark;
+            mark.tell = record_tell( seg );
+            mark.residual = mark.tell == seg.vrl ? 0 : seg.vrend - seg.pos;
+
+            mark.isexplicit  = seg.attrs & DLIS_SEGATTR_EXFMTLR;
+            mark.isencrypted = seg.attrs & DLIS_SEGATTR_ENCRYPT;
+            mark.type        = seg.type;
+
+            const bool named = !mark.isexplicit && !mark.isencrypted;
+            if (named && seg.named)
+                mark.name = std::move( seg.name );
+
+            marks.push_back( std::move( mark ) );
+            unnamed.push_back( named && !seg.named );
+        }
+
+        if (cut) {
+            truncated = start ? record_tell( chunk.back() ) : -1;
+            break;
+        }
+
+        std::vector< segment >().swap( chunk );
+    }
+
+    if (!start) {
+        truncated = marks.back().tell;
+        marks.pop_back();
+        unnamed.pop_back();
+    }
+
+    /*
+     * The records with names split across segments are re-read with tag(),
+     * now that the records that are cut off are gone
+     */
+    for (std::size_t i = 0; i < marks.size(); ++i) {
+        if (!unnamed[ i ]) continue;
+
+        report->fallbacks += 1;
+        file.seek( marks[ i ].tell );
+        marks[ i ] = tag( file, marks[ i ].residual ).second;
+    }
+
+    /*
+     * Like scan_record, forget the visible records entered by the record
+     * that is cut off
+     */
+    if (vrls) {
+        for (const auto label : labels) {
+            if (truncated >= 0 && label >= truncated) break;
+            vrls->push_back( label, visible_record_length( data + label ) );
+        }
+    }
+
+    report->truncated = truncated;
+    file.seek( truncated >= 0 ? truncated : size );
+    return marks;
+}
+
+namespace {
+
+/*
+ * Check that the visible record at pos is consistent, i.e. that its segments
+ * exactly fill it, and that it is followed by either another plausible label
+ * or the end of the file. This is a lot stricter than plausible_vrl, as it's
+ * used for recovering, and a false positive would resume in the middle of
+ * something else.
+ */
+bool consistent_vr( const char* data, std::int64_t size, std::int64_t pos )
+noexcept (true) {
+    if (!plausible_vrl( data, pos, size )) return false;
+
+    const auto vrend = pos + visible_record_length( data + pos );
+    if (vrend != size && !plausible_vrl( data, vrend, size )) return false;
+
+    auto seg = pos + DLIS_VRL_SIZE;
+    while (seg < vrend) {
+        if (seg + DLIS_LRSH_SIZE > vrend) return false;
+
+        int seglen, type;
+        std::uint8_t attrs;
+        dlis_lrsh( data + seg, &seglen, &attrs, &type );
+
+        /* RP66 segments are at least 16 bytes */
+        if (seglen < 16) return false;
+        seg += seglen;
+    }
+
+    return seg == vrend;
+}
+
+}
+
+bool resync( const mapped_file& file, scan_state& state, vrl_table* vrls ) {
+    const auto* data = file.data();
+    const std::int64_t size = file.size();
+
+    auto from = state.pos + 1;
+    while (from < size) {
+        const auto pos = find_vrl( data, size, from );
+        if (pos < 0) return false;
+        from = pos + 1;
+
+        if (!consistent_vr( data, size, pos )) continue;
+
+        /*
+         * The first segments could be the tail of a record that started
+         * before the damage, so resume at the first segment that starts a
+         * record
+         */
+        const auto vrend = pos + visible_record_length( data + pos );
+        auto seg = pos + DLIS_VRL_SIZE;
+        while (seg < vrend) {
+            int seglen, type;
+            std::uint8_t attrs;
+            dlis_lrsh( data + seg, &seglen, &attrs, &type );
+
+            if (!(attrs & DLIS_SEGATTR_PREDSEG)) break;
+            seg += seglen;
+        }
+
+        if (seg == vrend) continue;
+
+        if (seg == pos + DLIS_VRL_SIZE) {
+            state.pos = pos;
+            state.remaining = 0;
+        } else {
+            state.pos = seg;
+            state.remaining = int( vrend - seg );
+            if (vrls) vrls->push_back( pos, int( vrend - pos ) );
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+std::size_t record_index::size() const noexcept (true) {
+    return this->tells.size();
+}
+
+bookmark record_index::operator [] ( std::size_t i ) const {
+    bookmark mark;
+    mark.tell = this->tells.at( i );
+    mark.residual = this->residuals[ i ];
+
+    const auto flags = this->flags[ i ];
+    mark.isexplicit  = (flags & explicit_record)  ? DLIS_SEGATTR_EXFMTLR : 0;
+    mark.isencrypted = (flags & encrypted_record) ? DLIS_SEGATTR_ENCRYPT : 0;
+    mark.type = this->types[ i ];
+
+    const auto id = this->nameids[ i ];
+    if (id >= 0) mark.name = this->names[ id ];
+    else         mark.name = obname{};
+
+    return mark;
+}
+
+std::int32_t record_index::intern( const obname& name ) {
+    const auto k = key{
+        static_cast< std::int32_t >( name.origin ),
+        static_cast< std::uint8_t >( name.copy ),
+        static_cast< const std::string& >( name.id ),
+    };
+
+    const auto itr = this->interned.find( k );
+    if (itr != this->interned.end()) return itr->second;
+
+    const auto id = static_cast< std::int32_t >( this->names.size() );
+    this->interned.emplace( k, id );
+    this->names.push_back( name );
+    return id;
+}
+
+void record_index::push_back( const bookmark& mark ) {
+    std::uint8_t flags = 0;
+    if (mark.isexplicit)  flags |= explicit_record;
+    if (mark.isencrypted) flags |= encrypted_record;
+
+    const bool named = !flags;
+    this->tells.push_back( mark.tell );
+    this->residuals.push_back( mark.residual );
+    this->flags.push_back( flags );
+    this->types.push_back( mark.type );
+    this->nameids.push_back( named ? this->intern( mark.name ) : -1 );
+}
+
+namespace {
+
+/*
+ * Group the records by name, and find the explicits. The name ids are handed
+ * out in order of first appearance, so the groups are too.
+ */
+void group( file_index& index ) noexcept (false) {
+    const auto& records = index.records;
+    index.explicits.clear();
+    index.implicits.assign( records.names.size(), {} );
+
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        if (records.flags[ i ] & record_index::encrypted_record) continue;
+
+        if (records.flags[ i ] & record_index::explicit_record) {
+            index.explicits.push_back( i );
+            continue;
+        }
+
+        index.implicits[ records.nameids[ i ] ].push_back( i );
+    }
+}
+
+}
+
+file_index make_index( record_index records ) {
+    file_index index;
+    index.records = std::move( records );
+    group( index );
+    return index;
+}
+
+file_index make_index( std::vector< bookmark > marks ) {
+    record_index records;
+    for (auto& mark : marks) {
+        records.push_back( mark );
+        /* release the name as soon as it's interned */
+        mark = bookmark();
+    }
+
+    std::vector< bookmark >().swap( marks );
+    return make_index( std::move( records ) );
+}
+
+void write_index( const std::string& path,
+                  const std::string& dlispath,
+                  const file_index& index ) {
+    file_stat st;
+    if (!stat_file( dlispath, st ))
+        throw std::runtime_error( "unable to stat " + dlispath );
+
+    const auto& records = index.records;
+
+    std::vector< char > out( std::begin( index_magic ),
+                             std::end( index_magic ) );
+    put< std::int64_t >( out, st.size );
+    put< std::int64_t >( out, st.mtime );
+
+    put< std::uint32_t >( out, records.names.size() );
+    for (const auto& name : records.names) {
+        const auto& id = static_cast< const std::string& >( name.id );
+        put< std::int32_t >( out, std::int32_t( name.origin ) );
+        put< std::uint8_t >( out, name.copy );
+        put< std::uint32_t >( out, id.size() );
+        out.insert( out.end(), id.begin(), id.end() );
+    }
+
+    put< std::uint32_t >( out, records.size() );
+    for (const auto x : records.tells)     put< std::int64_t >( out, x );
+    for (const auto x : records.residuals) put< std::int32_t >( out, x );
+    for (const auto x : records.flags)     put< std::uint8_t >( out, x );
+    for (const auto x : records.types)     put< std::uint8_t >( out, x );
+    for (const auto x : records.nameids)   put< std::int32_t >( out, x );
+
+    const auto& vrls = index.vrls;
+    put< std::uint32_t >( out, vrls.size() );
+    for (const auto x : vrls.offsets) put< std::int64_t >( out, x );
+    for (const auto x : vrls.lengths) put< std::int32_t >( out, x );
+
+    const auto tmp = temp_path( path );
+    std::ofstream fs( tmp, std::ios_base::binary | std::ios_base::trunc );
+    fs.write( out.data(), out.size() );
+    fs.close();
+
+    if (!fs || !replace_file( tmp, path )) {
+        std::remove( tmp.c_str() );
+        throw std::runtime_error( "unable to write index " + path );
+    }
+}
+
+bool read_index( const std::string& path,
+                 const std::string& dlispath,
+                 file_index& out ) {
+    file_stat st;
+    if (!stat_file( dlispath, st )) return false;
+
+    std::ifstream fs( path, std::ios_base::binary );
+    if (!fs) return false;
+
+    const std::vector< char > buffer{
+        std::istreambuf_iterator< char >( fs ),
+        std::istreambuf_iterator< char >()
+    };
+
+    constexpr auto magiclen = sizeof( index_magic );
+    if (buffer.size() < magiclen) return false;
+    if (!std::equal( index_magic, index_magic + magiclen, buffer.begin() ))
+        return false;
+
+    index_reader in{ buffer.data() + magiclen,
+                     buffer.data() + buffer.size() };
+
+    const auto size  = in.get< std::int64_t >();
+    const auto mtime = in.get< std::int64_t >();
+    if (in.bad || size != st.size || mtime != st.mtime) return false;
+
+    file_index index;
+    auto& records = index.records;
+
+    const auto nnames = in.get< std::uint32_t >();
+    for (std::uint32_t i = 0; i < nnames && !in.bad; ++i) {
+        obname name;
+        name.origin = dl::origin{ in.get< std::int32_t >() };
+        name.copy   = dl::ushort{ in.get< std::uint8_t >() };
+        name.id     = dl::ident{ in.str( in.get< std::uint32_t >() ) };
+        if (records.intern( name ) != std::int32_t( i )) in.bad = true;
+    }
+
+    const auto count = in.get< std::uint32_t >();
+    if (in.bad) return false;
+
+    /* the columns are fixed size, so check that they fit before allocating */
+    const auto rowsize = sizeof( std::int64_t )
+                       + sizeof( std::int32_t )
+                       + sizeof( std::uint8_t )
+                       + sizeof( std::uint8_t )
+                       + sizeof( std::int32_t )
+                       ;
+    if (std::size_t( in.end - in.cur ) < count * rowsize) return false;
+
+    records.tells.resize( count );
+    records.residuals.resize( count );
+    records.flags.resize( count );
+    records.types.resize( count );
+    records.nameids.resize( count );
+    for (auto& x : records.tells)     x = in.get< std::int64_t >();
+    for (auto& x : records.residuals) x = in.get< std::int32_t >();
+    for (auto& x : records.flags)     x = in.get< std::uint8_t >();
+    for (auto& x : records.types)     x = in.get< std::uint8_t >();
+    for (auto& x : records.nameids)   x = in.get< std::int32_t >();
+
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const auto id = records.nameids[ i ];
+        const bool named = !records.flags[ i ];
+        if (named && (id < 0 || id >= std::int32_t( nnames ))) return false;
+        if (!named && id != -1) return false;
+    }
+
+    const auto nvrls = in.get< std::uint32_t >();
+    const auto vrlsize = sizeof( std::int64_t ) + sizeof( std::int32_t );
+    if (in.bad || std::size_t( in.end - in.cur ) != nvrls * vrlsize)
+        return false;
+
+    std::vector< std::int64_t > offsets( nvrls );
+    for (auto& x : offsets) x = in.get< std::int64_t >();
+    try {
+        for (const auto offset : offsets)
+            index.vrls.push_back( offset, in.get< std::int32_t >() );
+    } catch (const std::invalid_argument&) {
+        /* out-of-order visible records */
+        return false;
+    }
+
+    if (in.bad || in.cur != in.end) return false;
+
+    group( index );
+    out = std::move( index );
+    return true;
+}
+
+}
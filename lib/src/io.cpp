@@ -0,0 +1,904 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <dlisio/dlisio.h>
+#include <dlisio/types.h>
+#include <dlisio/ext/io.hpp>
+
+#include "parallel.hpp"
+
+namespace dl {
+
+namespace {
+
+[[noreturn]]
+void unexpected_eof( std::streamsize pos,
+                     std::streamsize nmemb,
+                     std::streamsize size ) noexcept (false) {
+    const auto msg = "unexpected end-of-file: reading "
+                   + std::to_string( nmemb ) + " bytes at "
+                   + std::to_string( pos ) + ", but file size is "
+                   + std::to_string( size )
+                   ;
+    throw std::out_of_range( msg );
+}
+
+}
+
+#ifdef _WIN32
+
+mapped_file::mapped_file( const std::string& path ) {
+    HANDLE fd = CreateFileA( path.c_str(),
+                             GENERIC_READ,
+                             FILE_SHARE_READ,
+                             nullptr,
+                             OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL,
+                             nullptr );
+
+    if (fd == INVALID_HANDLE_VALUE) {
+        const auto err = static_cast< int >( GetLastError() );
+        throw std::system_error( err, std::system_category(), path );
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx( fd, &size )) {
+        const auto err = static_cast< int >( GetLastError() );
+        CloseHandle( fd );
+        throw std::system_error( err, std::system_category(), path );
+    }
+
+    /* mapping an empty file is an error on windows, so leave it unmapped */
+    if (size.QuadPart == 0) {
+        CloseHandle( fd );
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA( fd, nullptr, PAGE_READONLY,
+                                         0, 0, nullptr );
+    const auto maperr = static_cast< int >( GetLastError() );
+    CloseHandle( fd );
+
+    if (!mapping)
+        throw std::system_error( maperr, std::system_category(), path );
+
+    const void* view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    if (!view) {
+        const auto err = static_cast< int >( GetLastError() );
+        CloseHandle( mapping );
+        throw std::system_error( err, std::system_category(), path );
+    }
+
+    this->base = static_cast< const char* >( view );
+    this->len = static_cast< std::streamsize >( size.QuadPart );
+    this->handle = mapping;
+}
+
+bool mapped_file::advise( std::streamsize, std::streamsize )
+const noexcept (true) {
+    /*
+     * PrefetchVirtualMemory is only available from windows 8, so leave it to
+     * the prefetching thread
+     */
+    return false;
+}
+
+void mapped_file::close() noexcept (true) {
+    if (this->base)   UnmapViewOfFile( this->base );
+    if (this->handle) CloseHandle( this->handle );
+
+    this->base = nullptr;
+    this->handle = nullptr;
+    this->len = 0;
+    this->pos = 0;
+}
+
+#else
+
+mapped_file::mapped_file( const std::string& path ) {
+    const int fd = ::open( path.c_str(), O_RDONLY );
+    if (fd == -1)
+        throw std::system_error( errno, std::generic_category(), path );
+
+    struct stat st;
+    if (::fstat( fd, &st ) == -1) {
+        const auto err = errno;
+        ::close( fd );
+        throw std::system_error( err, std::generic_category(), path );
+    }
+
+    /*
+     * mmap does not accept zero-length mappings, so leave empty files
+     * unmapped. An unmapped file behaves like it is at end-of-file
+     */
+    if (st.st_size == 0) {
+        ::close( fd );
+        return;
+    }
+
+    void* addr = ::mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    const auto err = errno;
+    /* the mapping keeps its own reference to the file */
+    ::close( fd );
+
+    if (addr == MAP_FAILED)
+        throw std::system_error( err, std::generic_category(), path );
+
+    this->base = static_cast< const char* >( addr );
+    this->len = static_cast< std::streamsize >( st.st_size );
+}
+
+bool mapped_file::advise( std::streamsize begin, std::streamsize end )
+const noexcept (true) {
+#ifdef MADV_WILLNEED
+    if (!this->base) return true;
+
+    begin = std::max< std::streamsize >( begin, 0 );
+    end   = std::min< std::streamsize >( end, this->len );
+    if (begin >= end) return true;
+
+    /* madvise wants a page-aligned address */
+    const auto pagesize = static_cast< std::streamsize >( ::sysconf( _SC_PAGESIZE ) );
+    const auto aligned = begin - (begin % pagesize);
+    auto* addr = const_cast< char* >( this->base + aligned );
+    return ::madvise( addr, end - aligned, MADV_WILLNEED ) == 0;
+#else
+    (void) begin;
+    (void) end;
+    return false;
+#endif
+}
+
+void mapped_file::close() noexcept (true) {
+    if (this->base)
+        ::munmap( const_cast< char* >( this->base ), this->len );
+
+    this->base = nullptr;
+    this->len = 0;
+    this->pos = 0;
+}
+
+#endif // _WIN32
+
+mapped_file::~mapped_file() {
+    this->close();
+}
+
+mapped_file::mapped_file( mapped_file&& other ) noexcept (true) :
+    base( other.base ),
+    len( other.len ),
+    pos( other.pos ),
+    handle( other.handle )
+{
+    other.base = nullptr;
+    other.len = 0;
+    other.pos = 0;
+    other.handle = nullptr;
+}
+
+mapped_file& mapped_file::operator = ( mapped_file&& other ) noexcept (true) {
+    mapped_file tmp( std::move( other ) );
+    std::swap( this->base,   tmp.base );
+    std::swap( this->len,    tmp.len );
+    std::swap( this->pos,    tmp.pos );
+    std::swap( this->handle, tmp.handle );
+    return *this;
+}
+
+std::vector< char > mapped_file::read( std::streamsize nmemb ) {
+    std::vector< char > xs( nmemb );
+    this->read( xs.data(), nmemb );
+    return xs;
+}
+
+char* mapped_file::read( char* buffer, std::streamsize nmemb ) {
+    const auto* src = this->view( nmemb );
+    std::memcpy( buffer, src, nmemb );
+    return buffer;
+}
+
+const char* mapped_file::view( std::streamsize nmemb ) noexcept (false) {
+    if (nmemb < 0 || nmemb > this->len - this->pos)
+        unexpected_eof( this->pos, nmemb, this->len );
+
+    const auto* ptr = this->base + this->pos;
+    this->pos += nmemb;
+    return ptr;
+}
+
+bool mapped_file::eof() const noexcept (true) {
+    return this->pos >= this->len;
+}
+
+std::streamsize mapped_file::tell() const noexcept (true) {
+    return this->pos;
+}
+
+mapped_file& mapped_file::seek( std::streamsize n ) noexcept (true) {
+    this->pos = n;
+    return *this;
+}
+
+mapped_file& mapped_file::skip( std::streamsize n ) noexcept (true) {
+    this->pos += n;
+    return *this;
+}
+
+std::streamsize mapped_file::size() const noexcept (true) {
+    return this->len;
+}
+
+const char* mapped_file::data() const noexcept (true) {
+    return this->base;
+}
+
+bool record_view::contiguous() const noexcept (true) {
+    return this->segments.size() <= 1;
+}
+
+std::size_t record_view::size() const noexcept (true) {
+    std::size_t n = 0;
+    for (const auto& seg : this->segments)
+        n += seg.size;
+    return n;
+}
+
+const char* record_view::data( std::vector< char >& buffer ) const {
+    if (this->segments.empty()) return nullptr;
+    if (this->contiguous()) return this->segments.front().data;
+
+    buffer.resize( this->size() );
+    auto* dst = buffer.data();
+    for (const auto& seg : this->segments) {
+        std::memcpy( dst, seg.data, seg.size );
+        dst += seg.size;
+    }
+
+    return buffer.data();
+}
+
+void record_view::clear() noexcept (true) {
+    this->segments.clear();
+}
+
+const char* record_view::slice( std::size_t offset,
+                                std::size_t nmemb,
+                                std::vector< char >& buffer ) const {
+    const auto start = offset;
+    auto seg = this->segments.begin();
+    const auto end = this->segments.end();
+
+    while (seg != end && offset >= seg->size) {
+        offset -= seg->size;
+        ++seg;
+    }
+
+    if (seg != end && offset + nmemb <= seg->size)
+        return seg->data + offset;
+
+    buffer.resize( nmemb );
+    std::size_t copied = 0;
+    for (; seg != end && copied < nmemb; ++seg) {
+        const auto count = std::min( seg->size - offset, nmemb - copied );
+        std::memcpy( buffer.data() + copied, seg->data + offset, count );
+        copied += count;
+        offset = 0;
+    }
+
+    if (copied < nmemb) {
+        const auto msg = "record slice out of range: "
+                       + std::to_string( nmemb ) + " bytes at "
+                       + std::to_string( start )
+                       + ", but record size is "
+                       + std::to_string( this->size() )
+                       ;
+        throw std::out_of_range( msg );
+    }
+
+    return buffer.data();
+}
+
+std::streamsize view_record( const mapped_file& fs,
+                             std::streamsize pos,
+                             int remaining,
+                             record_view& out ) {
+    out.clear();
+
+    const auto* data = fs.data();
+    const auto size = fs.size();
+
+    while (true) {
+        while (remaining > 0) {
+            if (pos + DLIS_LRSH_SIZE > size)
+                unexpected_eof( pos, DLIS_LRSH_SIZE, size );
+
+            int seglen, type;
+            std::uint8_t attrs;
+            dlis_lrsh( data + pos, &seglen, &attrs, &type );
+
+            if (seglen < DLIS_LRSH_SIZE) {
+                const auto msg = "bad segment header: segment length ("
+                               + std::to_string( seglen )
+                               + ") < "
+                               + std::to_string( DLIS_LRSH_SIZE )
+                               + " at "
+                               + std::to_string( pos )
+                               ;
+                throw std::runtime_error( msg );
+            }
+
+            if (seglen > size - pos)
+                unexpected_eof( pos, seglen, size );
+
+            remaining -= seglen;
+
+            const auto bodylen = seglen - DLIS_LRSH_SIZE;
+            const char* body = data + pos + DLIS_LRSH_SIZE;
+            pos += seglen;
+
+            /*
+             * The trailer is (in order) padding, checksum and trailing length,
+             * so strip them from the back
+             */
+            int trailer = 0;
+            if (attrs & DLIS_SEGATTR_TRAILEN) trailer += 2;
+            if (attrs & DLIS_SEGATTR_CHCKSUM) trailer += 2;
+            if (attrs & DLIS_SEGATTR_PADDING && bodylen > trailer) {
+                std::uint8_t padbytes = 0;
+                dlis_ushort( body + bodylen - trailer - 1, &padbytes );
+                trailer += padbytes;
+            }
+
+            if (trailer > bodylen) {
+                const auto msg = "bad segment trailer: trailer length ("
+                               + std::to_string( trailer )
+                               + ") > segment body length ("
+                               + std::to_string( bodylen )
+                               + ")"
+                               ;
+                throw std::runtime_error( msg );
+            }
+
+            span segment;
+            segment.data = body;
+            segment.size = bodylen - trailer;
+            out.segments.push_back( segment );
+            if (!(attrs & DLIS_SEGATTR_SUCCSEG)) return pos;
+        }
+
+        if (pos + DLIS_VRL_SIZE > size)
+            unexpected_eof( pos, DLIS_VRL_SIZE, size );
+
+        int len, version;
+        dlis_vrl( data + pos, &len, &version );
+        if (len < DLIS_VRL_SIZE) {
+            const auto msg = "visible record length < "
+                           + std::to_string( DLIS_VRL_SIZE ) + " (was "
+                           + std::to_string( len ) + ") at "
+                           + std::to_string( pos )
+                           ;
+            throw std::runtime_error( msg );
+        }
+
+        remaining = len - DLIS_VRL_SIZE;
+        pos += DLIS_VRL_SIZE;
+    }
+}
+
+void view_record( mapped_file& fs, int remaining, record_view& out ) {
+    const mapped_file& file = fs;
+    fs.seek( view_record( file, fs.tell(), remaining, out ) );
+}
+
+frame_plan::frame_plan( const std::vector< int >& reprcs,
+                        const std::vector< int >& counts ) :
+    reprcs( reprcs.begin(), reprcs.end() ),
+    counts( counts.begin(), counts.end() )
+{
+    if (reprcs.size() != counts.size()) {
+        const auto msg = "frame_plan: got "
+                       + std::to_string( reprcs.size() )
+                       + " representation codes, but "
+                       + std::to_string( counts.size() )
+                       + " counts"
+                       ;
+        throw std::invalid_argument( msg );
+    }
+
+    std::size_t pos = 0;
+    bool variable = false;
+    for (std::size_t i = 0; i < reprcs.size(); ++i) {
+        const auto size = dlis_sizeof_type( reprcs[ i ] );
+        if (size < 0) {
+            const auto msg = "frame_plan: invalid representation code "
+                           + std::to_string( reprcs[ i ] )
+                           + " for channel "
+                           + std::to_string( i )
+                           ;
+            throw std::invalid_argument( msg );
+        }
+
+        if (counts[ i ] < 0) {
+            const auto msg = "frame_plan: negative count "
+                           + std::to_string( counts[ i ] )
+                           + " for channel "
+                           + std::to_string( i )
+                           ;
+            throw std::invalid_argument( msg );
+        }
+
+        const auto width = std::size_t( size ) * std::size_t( counts[ i ] );
+        this->widths.push_back( width );
+
+        if (!variable) this->offsets.push_back( pos );
+        pos += width;
+        variable = variable || size == DLIS_VARIABLE_LENGTH;
+    }
+}
+
+std::size_t frame_plan::size() const noexcept (true) {
+    return this->reprcs.size();
+}
+
+int frame_plan::reprc( std::size_t channel ) const noexcept (false) {
+    return this->reprcs.at( channel );
+}
+
+int frame_plan::count( std::size_t channel ) const noexcept (false) {
+    return this->counts.at( channel );
+}
+
+bool frame_plan::fixed( std::size_t channel ) const noexcept (false) {
+    return channel < this->offsets.size()
+        && dlis_sizeof_type( this->reprc( channel ) ) != DLIS_VARIABLE_LENGTH;
+}
+
+std::size_t frame_plan::width( std::size_t channel ) const noexcept (false) {
+    return this->widths.at( channel );
+}
+
+std::size_t frame_plan::offset( std::size_t channel,
+                               const char* body,
+                               const char* end ) const
+noexcept (false) {
+    if (channel >= this->size())
+        throw std::out_of_range( "frame_plan: channel out of range" );
+
+    if (channel < this->offsets.size())
+        return this->offsets[ channel ];
+
+    /*
+     * skip from the first variable-size channel, which is the last one with
+     * a known offset
+     */
+    const auto first = this->offsets.size() - 1;
+    const auto known = this->offsets.back();
+    if (known > std::size_t( end - body ))
+        throw std::out_of_range( "frame_plan: frame past end-of-record" );
+
+    std::vector< std::size_t > skipped( channel - first + 1 );
+    const auto err = dlis_frame_offsets( body + known,
+                                         end,
+                                         channel - first,
+                                         this->counts.data() + first,
+                                         this->reprcs.data() + first,
+                                         skipped.data() );
+    if (err) {
+        const auto msg = "frame_plan: channels before "
+                       + std::to_string( channel )
+                       + " past end-of-record"
+                       ;
+        throw std::out_of_range( msg );
+    }
+
+    return known + skipped.back();
+}
+
+frame_plan make_frame_plan( const std::vector< const channel* >& channels ) {
+    std::vector< int > reprcs;
+    std::vector< int > counts;
+    reprcs.reserve( channels.size() );
+    counts.reserve( channels.size() );
+
+    for (const auto* ch : channels) {
+        /*
+         * a sample is dimension[0] * dimension[1] * ... values, and the
+         * element limit is the upper bound on the dimension
+         */
+        const auto& shape = ch->dimension.empty() ? ch->element_limit
+                                                  : ch->dimension;
+        int count = 1;
+        for (const auto extent : shape)
+            count *= decay( extent );
+
+        reprcs.push_back( static_cast< int >( ch->reprc ) );
+        counts.push_back( count );
+    }
+
+    return frame_plan( reprcs, counts );
+}
+
+void vrl_table::push_back( std::int64_t offset, std::int32_t length ) {
+    if (!this->offsets.empty() && offset < this->offsets.back())
+        throw std::invalid_argument( "visible records must be added in order" );
+
+    const auto start = this->starts.empty()
+                     ? 0
+                     : this->starts.back() + this->lengths.back() - DLIS_VRL_SIZE
+                     ;
+
+    this->offsets.push_back( offset );
+    this->lengths.push_back( length );
+    this->starts.push_back( start );
+}
+
+std::size_t vrl_table::size() const noexcept (true) {
+    return this->offsets.size();
+}
+
+void vrl_table::resize( std::size_t n ) {
+    this->offsets.resize( n );
+    this->lengths.resize( n );
+    this->starts.resize( n );
+}
+
+std::size_t vrl_table::find( std::int64_t physical ) const {
+    const auto itr = std::upper_bound( this->offsets.begin(),
+                                       this->offsets.end(),
+                                       physical );
+
+    if (itr != this->offsets.begin()) {
+        const auto i = std::distance( this->offsets.begin(), itr ) - 1;
+        if (physical < this->offsets[ i ] + this->lengths[ i ])
+            return i;
+    }
+
+    const auto msg = "offset " + std::to_string( physical )
+                   + " is not in a visible record"
+                   ;
+    throw std::out_of_range( msg );
+}
+
+std::int64_t vrl_table::physical( std::int64_t logical ) const {
+    const auto itr = std::upper_bound( this->starts.begin(),
+                                       this->starts.end(),
+                                       logical );
+
+    if (itr != this->starts.begin() && logical >= 0) {
+        const auto i = std::distance( this->starts.begin(), itr ) - 1;
+        const auto offset = logical - this->starts[ i ];
+        if (offset < this->lengths[ i ] - DLIS_VRL_SIZE)
+            return this->offsets[ i ] + DLIS_VRL_SIZE + offset;
+    }
+
+    const auto msg = "logical offset " + std::to_string( logical )
+                   + " is past the last visible record"
+                   ;
+    throw std::out_of_range( msg );
+}
+
+std::int64_t vrl_table::logical( std::int64_t physical ) const {
+    const auto i = this->find( physical );
+    const auto offset = physical - this->offsets[ i ] - DLIS_VRL_SIZE;
+    if (offset < 0) {
+        const auto msg = "offset " + std::to_string( physical )
+                       + " is in a visible record label"
+                       ;
+        throw std::out_of_range( msg );
+    }
+
+    return this->starts[ i ] + offset;
+}
+
+int vrl_table::remaining( std::int64_t physical ) const {
+    const auto i = this->find( physical );
+    return int( this->offsets[ i ] + this->lengths[ i ] - physical );
+}
+
+namespace {
+
+/*
+ * Parse the object name in xs[0, len), with bounds checks. Returns false if
+ * the name does not fit.
+ */
+bool scan_obname( const char* xs, std::size_t len, obname& name )
+noexcept (true) {
+    if (len < 1) return false;
+
+    /* the two high bits of the first byte determines the length of uvari */
+    const auto lead = std::uint8_t( xs[ 0 ] );
+    const std::size_t originlen = (lead & 0x80) == 0 ? 1
+                                : (lead & 0x40) == 0 ? 2
+                                : 4
+                                ;
+
+    if (len < originlen + 2) return false;
+
+    std::int32_t origin;
+    std::uint8_t copy;
+    std::uint8_t idlen;
+    const auto* ptr = dlis_uvari( xs, &origin );
+    ptr = dlis_ushort( ptr, &copy );
+    ptr = dlis_ushort( ptr, &idlen );
+
+    if (len < originlen + 2 + idlen) return false;
+
+    name.origin = dl::origin{ origin };
+    name.copy = copy;
+    name.id = dl::ident{ std::string( ptr, ptr + idlen ) };
+    return true;
+}
+
+}
+
+int scan_record( const mapped_file& file,
+                 scan_state& state,
+                 bookmark& mark,
+                 vrl_table* vrls ) {
+    const auto* data = file.data();
+    const auto size = file.size();
+
+    auto pos = state.pos;
+    auto remaining = state.remaining;
+
+    if (remaining == 0 && pos >= size) return DLIS_EOF;
+
+    /* on errors, forget the visible records entered by this record */
+    const auto entries = vrls ? vrls->size() : 0;
+    const auto fail = [=]( int err ) {
+        if (vrls) vrls->resize( entries );
+        return err;
+    };
+
+    bookmark out;
+    out.tell = pos;
+    out.residual = remaining;
+
+    /*
+     * the object name is at most 4 (origin) + 1 (copy) + 256 (id) bytes, and
+     * may be split across segments, so gather the start of the body
+     */
+    std::array< char, 261 > head;
+    std::size_t headlen = 0;
+    bool first = true;
+
+    while (true) {
+        if (remaining == 0) {
+            if (pos + DLIS_VRL_SIZE > size) return fail( DLIS_TRUNCATED );
+
+            int len, version;
+            dlis_vrl( data + pos, &len, &version );
+            if (len < DLIS_VRL_SIZE) return fail( DLIS_INCONSISTENT );
+            if (vrls) vrls->push_back( pos, len );
+
+            remaining = len - DLIS_VRL_SIZE;
+            pos += DLIS_VRL_SIZE;
+        }
+
+        if (pos + DLIS_LRSH_SIZE > size) return fail( DLIS_TRUNCATED );
+
+        int seglen, type;
+        std::uint8_t attrs;
+        dlis_lrsh( data + pos, &seglen, &attrs, &type );
+
+        if (seglen < DLIS_LRSH_SIZE) return fail( DLIS_INCONSISTENT );
+        if (seglen > remaining)      return fail( DLIS_INCONSISTENT );
+        if (pos + seglen > size)     return fail( DLIS_TRUNCATED );
+
+        if (first) {
+            out.isexplicit  = attrs & DLIS_SEGATTR_EXFMTLR;
+            out.isencrypted = attrs & DLIS_SEGATTR_ENCRYPT;
+            out.type        = type;
+            first = false;
+        }
+
+        const bool named = !out.isexplicit && !out.isencrypted;
+        if (named && headlen < head.size()) {
+            const auto bodylen = std::size_t( seglen - DLIS_LRSH_SIZE );
+            const auto count = std::min( bodylen, head.size() - headlen );
+            std::memcpy( head.data() + headlen,
+                         data + pos + DLIS_LRSH_SIZE,
+                         count );
+            headlen += count;
+        }
+
+        pos += seglen;
+        remaining -= seglen;
+
+        if (!(attrs & DLIS_SEGATTR_SUCCSEG)) break;
+    }
+
+    if (!out.isexplicit && !out.isencrypted) {
+        if (!scan_obname( head.data(), headlen, out.name ))
+            return fail( DLIS_INCONSISTENT );
+    }
+
+    state.pos = pos;
+    state.remaining = remaining;
+    mark = std::move( out );
+    return DLIS_OK;
+}
+
+std::vector< byte_range > coalesce( std::vector< byte_range > ranges,
+                                    std::streamsize gap ) {
+    if (ranges.empty()) return ranges;
+
+    std::sort( ranges.begin(), ranges.end(),
+        []( const byte_range& lhs, const byte_range& rhs ) {
+            return lhs.begin < rhs.begin;
+        }
+    );
+
+    std::vector< byte_range > merged;
+    merged.push_back( ranges.front() );
+    for (const auto& range : ranges) {
+        auto& last = merged.back();
+        if (range.begin <= last.end + gap)
+            last.end = std::max( last.end, range.end );
+        else
+            merged.push_back( range );
+    }
+
+    return merged;
+}
+
+record_batch::record_batch( const mapped_file& fs,
+                            const record_index& index,
+                            const std::vector< std::size_t >& positions,
+                            std::streamsize gap ) :
+    file( fs ),
+    views( positions.size() ),
+    errors( positions.size() ),
+    fetched( positions.size(), 0 ),
+    done( false )
+{
+    /*
+     * A record ends where the next record in the file starts, so the bytes
+     * to read ahead are known from the index alone, without touching the
+     * file. Reading the headers is left to operator [], so that the reads
+     * issued here overlap with decoding the first records.
+     */
+    this->marks.reserve( positions.size() );
+    std::vector< byte_range > ranges;
+    for (const auto pos : positions) {
+        this->marks.push_back( index[ pos ] );
+        if (this->marks.back().isencrypted) continue;
+
+        byte_range range;
+        range.begin = index.tells[ pos ];
+        range.end = pos + 1 < index.size() ? index.tells[ pos + 1 ]
+                                           : fs.size();
+        ranges.push_back( range );
+    }
+
+    this->merged = coalesce( std::move( ranges ), gap );
+
+    bool advised = true;
+    for (const auto& range : this->merged)
+        advised = fs.advise( range.begin, range.end ) && advised;
+
+    if (advised) return;
+
+    /*
+     * Touch a byte in every page of the ranges, which faults them in ahead
+     * of the caller. The sum is only there so that the reads are not
+     * optimised away.
+     */
+    const auto* base = fs.data();
+    const auto size = fs.size();
+    this->prefetcher = std::thread( [this, base, size] {
+        constexpr std::streamsize pagesize = 4096;
+        volatile std::uint8_t sink = 0;
+        for (const auto& range : this->merged) {
+            const auto end = std::min( range.end, size );
+            for (auto pos = range.begin; pos < end; pos += pagesize) {
+                if (this->done) return;
+                sink += std::uint8_t( base[ pos ] );
+            }
+        }
+    });
+}
+
+record_batch::~record_batch() {
+    this->done = true;
+    if (this->prefetcher.joinable())
+        this->prefetcher.join();
+}
+
+std::size_t record_batch::size() const noexcept (true) {
+    return this->views.size();
+}
+
+const record_view& record_batch::operator [] ( std::size_t i )
+noexcept (false) {
+    if (!this->fetched[ i ]) {
+        const auto& mark = this->marks[ i ];
+        if (!mark.isencrypted) try {
+            view_record( this->file, mark.tell, mark.residual, this->views[ i ] );
+        } catch (...) {
+            this->views[ i ].clear();
+            this->errors[ i ] = std::current_exception();
+        }
+        this->fetched[ i ] = 1;
+    }
+
+    if (this->errors[ i ]) std::rethrow_exception( this->errors[ i ] );
+    return this->views[ i ];
+}
+
+const bookmark& record_batch::mark( std::size_t i ) const noexcept (true) {
+    return this->marks[ i ];
+}
+
+const std::vector< byte_range >& record_batch::ranges() const noexcept (true) {
+    return this->merged;
+}
+
+std::vector< object_set > parse_eflrs( mapped_file& fs,
+                                       const record_index& index,
+                                       const std::vector< std::size_t >& positions,
+                                       int threads,
+                                       std::vector< std::exception_ptr >* errors ) {
+    if (threads < 0)
+        throw std::invalid_argument( "threads must be non-negative" );
+
+    if (threads == 0)
+        threads = std::max( 1u, std::thread::hardware_concurrency() );
+
+    /*
+     * The views only point into the mapping, and every record is viewed by
+     * a single worker, so the records can be viewed and parsed in any order
+     */
+    record_batch batch( fs, index, positions );
+
+    std::vector< object_set > sets( batch.size() );
+    if (errors) errors->assign( batch.size(), nullptr );
+
+    parallel_for( int( batch.size() ), threads, [&]( int i ) {
+        const auto& mark = batch.mark( i );
+        if (mark.isencrypted) return;
+
+        try {
+            /* the buffer is only used by segmented records */
+            std::vector< char > buffer;
+            const auto& view = batch[ i ];
+            const auto* begin = view.data( buffer );
+            const auto* end = begin + view.size();
+            sets[ i ] = parse_eflr( begin, end, mark.type );
+        } catch (...) {
+            if (!errors) throw;
+            (*errors)[ i ] = std::current_exception();
+        }
+    });
+
+    return sets;
+}
+
+std::vector< object_set > parse_eflrs( mapped_file& fs,
+                                       const file_index& index,
+                                       int threads ) {
+    return parse_eflrs( fs, index.records, index.explicits, threads );
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef DLISIO_SRC_PARALLEL_HPP
+#define DLISIO_SRC_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace dl {
+
+/*
+ * Run fn( i ) for all i in [0, n), spread over (up to) threads threads. If
+ * any invocation throws, the exception from the lowest i is re-thrown in the
+ * calling thread once all workers are done, which is the same exception a
+ * sequential loop would have stopped at.
+ *
+ * This is an implementation detail of the indexer and parse_eflrs, and not
+ * part of the installed headers.
+ */
+template< typename Fn >
+void parallel_for( int n, int threads, Fn fn ) noexcept (false) {
+    if (threads <= 1 || n <= 1) {
+        for (int i = 0; i < n; ++i) fn( i );
+        return;
+    }
+
+    std::vector< std::exception_ptr > errors( n );
+    std::atomic< int > next( 0 );
+
+    const auto work = [&] {
+        for (int i = next++; i < n; i = next++) try {
+            fn( i );
+        } catch (...) {
+            errors[ i ] = std::current_exception();
+        }
+    };
+
+    std::vector< std::thread > workers;
+    for (int i = 1; i < std::min( n, threads ); ++i)
+        workers.emplace_back( work );
+
+    work();
+    for (auto& worker : workers) worker.join();
+
+    for (const auto& err : errors)
+        if (err) std::rethrow_exception( err );
+}
+
+}
+
+#endif // DLISIO_SRC_PARALLEL_HPP
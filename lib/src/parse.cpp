@@ -2,6 +2,8 @@
 #include <bitset>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <memory>
 #include <string>
 
 #include <dlisio/dlisio.h>
@@ -69,11 +71,11 @@ set_descriptor parse_set_descriptor( const char* cur ) noexcept (false) {
 }
 
 struct attribute_descriptor {
-    bool label;
-    bool count;
-    bool reprc;
-    bool units;
-    bool value;
+    bool label = false;
+    bool count = false;
+    bool reprc = false;
+    bool units = false;
+    bool value = false;
     bool object = false;
     bool absent = false;
     bool invariant = false;
@@ -455,83 +457,313 @@ const char* cast( const char* xs,
     return xs;
 }
 
-struct copy_elements : boost::static_visitor< const char* > {
-    const char* begin;
-    long count;
+/*
+ * Find the count values of type reprc that start at xs, without decoding
+ * them. Only the length prefixes of variable-length values are read. The
+ * values are decoded later, on typed access through value_vector::get
+ */
+const char* elements( const char* xs, const char* end,
+                                      dl::uvari count,
+                                      dl::representation_code reprc,
+                                      dl::value_vector& vec ) {
+    const auto n = static_cast< dl::uvari::value_type >( count );
+    if (n < 0) {
+        const auto msg = "invalid count (count = "
+                       + std::to_string( n )
+                       + "), expected count >= 0"
+                       ;
+        throw std::invalid_argument( msg );
+    }
 
-    copy_elements( const char* xs, long n ) :
-        begin( xs ), count( n )
-    {}
+    const auto rc = static_cast< int >( reprc );
+    if (dlis_sizeof_type( rc ) < 0) {
+        const auto msg = "invalid representation code (reprc = "
+                       + std::to_string( rc )
+                       + ")"
+                       ;
+        throw std::invalid_argument( msg );
+    }
 
-    template < typename T >
-    const char* operator()( std::vector< T >& out ) const {
-        T elem;
-        std::vector< T > tmp;
-        auto xs = this->begin;
+    /* the values are untrusted, so never read past end to find their size */
+    const auto* last = dlis_skip_bounded( rc, xs, end, std::size_t( n ) );
+    if (!last)
+        throw std::out_of_range( "attribute value past end-of-record" );
 
-        for( std::int32_t i = 0; i < this->count; ++i ) {
-            xs = cast( xs, elem );
-            tmp.push_back( std::move( elem ) );
-        }
+    vec = dl::value_vector( reprc, n, xs, last );
+    return last;
+}
 
-        out.swap( tmp );
-        return xs;
-    }
-};
+/*
+ * Label dispatch for the typed objects
+ *
+ * The labels an object type understands are listed once, in a table, which
+ * generates both an enum of the fields and the label -> field lookup. The
+ * lookup hashes the label once and switches on the hash, with the case labels
+ * computed at compile time from the same table. Two labels of the same object
+ * hashing to the same value is then a compile error (duplicate case), and a
+ * single string compare in the matching case rules out unknown labels that
+ * collide with a known one.
+ *
+ * The hash is 32-bit FNV-1a.
+ */
+constexpr std::uint32_t fnv1a( const char* str,
+                               std::uint32_t hash = 2166136261u )
+noexcept (true) {
+    return *str == '\0'
+         ? hash
+         : fnv1a( str + 1, (hash ^ std::uint8_t( *str )) * 16777619u )
+         ;
+}
+
+std::uint32_t fnv1a( const std::string& str ) noexcept (true) {
+    std::uint32_t hash = 2166136261u;
+    for (const auto c : str)
+        hash = (hash ^ std::uint8_t( c )) * 16777619u;
+
+    return hash;
+}
+
+template < typename Object > struct labels;
+
+#define DLIS_LABEL_FIELD(name, label) name,
+#define DLIS_LABEL_CASE(name, label) \
+    case fnv1a( label ): \
+        if (str == label) return field::name; \
+        break;
+
+#define DLIS_REGISTER_LABELS(type, table) \
+    template <> struct labels< type > { \
+        enum class field { unknown, table(DLIS_LABEL_FIELD) }; \
+        static field lookup( const std::string& str ) noexcept (true) { \
+            switch (fnv1a( str )) { \
+                table(DLIS_LABEL_CASE) \
+            } \
+            return field::unknown; \
+        } \
+    };
 
-dl::value_vector values_from_reprc( dl::representation_code reprc ) {
+/* 5.1.1 File-Header objects */
+#define DLIS_FILE_HEADER_LABELS(X) \
+    X(sequence_number, "SEQUENCE-NUMBER") \
+    X(id,              "ID")
+
+/* 5.5.1 Channel objects */
+#define DLIS_CHANNEL_LABELS(X) \
+    X(long_name,     "LONG-NAME") \
+    X(properties,    "PROPERTIES") \
+    X(reprc,         "REPRESENTATION-CODE") \
+    X(units,         "UNITS") \
+    X(dimension,     "DIMENSION") \
+    X(axis,          "AXIS") \
+    X(element_limit, "ELEMENT-LIMIT") \
+    X(source,        "SOURCE")
+
+/* 5.2.1 Origin objects */
+#define DLIS_ORIGIN_LABELS(X) \
+    X(file_id,           "FILE-ID") \
+    X(file_set_name,     "FILE-SET-NAME") \
+    X(file_set_number,   "FILE-SET-NUMBER") \
+    X(file_number,       "FILE-NUMBER") \
+    X(file_type,         "FILE-TYPE") \
+    X(product,           "PRODUCT") \
+    X(version,           "VERSION") \
+    X(programs,          "PROGRAMS") \
+    X(creation_time,     "CREATION-TIME") \
+    X(order_number,      "ORDER-NUMBER") \
+    X(descent_number,    "DESCENT-NUMBER") \
+    X(run_number,        "RUN-NUMBER") \
+    X(well_id,           "WELL-ID") \
+    X(well_name,         "WELL-NAME") \
+    X(field_name,        "FIELD-NAME") \
+    X(producer_code,     "PRODUCER-CODE") \
+    X(producer_name,     "PRODUCER-NAME") \
+    X(company,           "COMPANY") \
+    X(namespace_name,    "NAME-SPACE-NAME") \
+    X(namespace_version, "NAME-SPACE-VERSION")
+
+/* 5.3.1 Axis objects */
+#define DLIS_AXIS_LABELS(X) \
+    X(axis_id,     "AXIS-ID") \
+    X(coordinates, "COORDINATES") \
+    X(spacing,     "SPACING")
+
+/* 5.7.1 Frame objects */
+#define DLIS_FRAME_LABELS(X) \
+    X(description, "DESCRIPTION") \
+    X(channels,    "CHANNELS") \
+    X(index_type,  "INDEX-TYPE") \
+    X(direction,   "DIRECTION") \
+    X(spacing,     "SPACING") \
+    X(encrypted,   "ENCRYPTED") \
+    X(index_min,   "INDEX-MIN") \
+    X(index_max,   "INDEX-MAX")
+
+/* 5.8.1 Zone objects */
+#define DLIS_ZONE_LABELS(X) \
+    X(description, "DESCRIPTION") \
+    X(domain,      "DOMAIN") \
+    X(maximum,     "MAXIMUM") \
+    X(minimum,     "MINIMUM")
+
+/* 5.8.2 Parameter objects */
+#define DLIS_PARAMETER_LABELS(X) \
+    X(long_name, "LONG-NAME") \
+    X(dimension, "DIMENSION") \
+    X(axis,      "AXIS") \
+    X(zones,     "ZONES") \
+    X(values,    "VALUES")
+
+/* 5.8.4 Tool objects */
+#define DLIS_TOOL_LABELS(X) \
+    X(description,    "DESCRIPTION") \
+    X(trademark_name, "TRADEMARK-NAME") \
+    X(generic_name,   "GENERIC-NAME") \
+    X(parts,          "PARTS") \
+    X(status,         "STATUS") \
+    X(channels,       "CHANNELS") \
+    X(parameters,     "PARAMETERS")
+
+DLIS_REGISTER_LABELS(dl::file_header,   DLIS_FILE_HEADER_LABELS)
+DLIS_REGISTER_LABELS(dl::origin_object, DLIS_ORIGIN_LABELS)
+DLIS_REGISTER_LABELS(dl::axis,          DLIS_AXIS_LABELS)
+DLIS_REGISTER_LABELS(dl::channel,       DLIS_CHANNEL_LABELS)
+DLIS_REGISTER_LABELS(dl::frame,         DLIS_FRAME_LABELS)
+DLIS_REGISTER_LABELS(dl::zone,          DLIS_ZONE_LABELS)
+DLIS_REGISTER_LABELS(dl::parameter,     DLIS_PARAMETER_LABELS)
+DLIS_REGISTER_LABELS(dl::tool,          DLIS_TOOL_LABELS)
+
+#undef DLIS_TOOL_LABELS
+#undef DLIS_PARAMETER_LABELS
+#undef DLIS_ZONE_LABELS
+#undef DLIS_FRAME_LABELS
+#undef DLIS_AXIS_LABELS
+#undef DLIS_ORIGIN_LABELS
+#undef DLIS_CHANNEL_LABELS
+#undef DLIS_FILE_HEADER_LABELS
+#undef DLIS_REGISTER_LABELS
+#undef DLIS_LABEL_CASE
+#undef DLIS_LABEL_FIELD
+
+/*
+ * LONG-NAME of channels and parameters is either an obname (referring to a
+ * LONG-NAME object) or the name itself, as ascii
+ */
+void long_name( const dl::object_attribute& attr,
+                boost::variant< dl::obname, dl::ascii >& name,
+                bool allow_empty ) noexcept (false) {
     using rep = dl::representation_code;
-    switch (reprc) {
-        case rep::fshort: return std::vector< dl::fshort >{};
-        case rep::fsingl: return std::vector< dl::fsingl >{};
-        case rep::fsing1: return std::vector< dl::fsing1 >{};
-        case rep::fsing2: return std::vector< dl::fsing2 >{};
-        case rep::isingl: return std::vector< dl::isingl >{};
-        case rep::vsingl: return std::vector< dl::vsingl >{};
-        case rep::fdoubl: return std::vector< dl::fdoubl >{};
-        case rep::fdoub1: return std::vector< dl::fdoub1 >{};
-        case rep::fdoub2: return std::vector< dl::fdoub2 >{};
-        case rep::csingl: return std::vector< dl::csingl >{};
-        case rep::cdoubl: return std::vector< dl::cdoubl >{};
-        case rep::sshort: return std::vector< dl::sshort >{};
-        case rep::snorm : return std::vector< dl::snorm  >{};
-        case rep::slong : return std::vector< dl::slong  >{};
-        case rep::ushort: return std::vector< dl::ushort >{};
-        case rep::unorm : return std::vector< dl::unorm  >{};
-        case rep::ulong : return std::vector< dl::ulong  >{};
-        case rep::uvari : return std::vector< dl::uvari  >{};
-        case rep::ident : return std::vector< dl::ident  >{};
-        case rep::ascii : return std::vector< dl::ascii  >{};
-        case rep::dtime : return std::vector< dl::dtime  >{};
-        case rep::origin: return std::vector< dl::origin >{};
-        case rep::obname: return std::vector< dl::obname >{};
-        case rep::objref: return std::vector< dl::objref >{};
-        case rep::attref: return std::vector< dl::attref >{};
-        case rep::status: return std::vector< dl::status >{};
-        case rep::units : return std::vector< dl::units  >{};
 
+    if (attr.value.empty() && allow_empty) {
+        name = dl::obname{};
+        return;
     }
 
-    const auto msg = "unknown representation code "
-                   + std::to_string( static_cast< std::uint8_t >( reprc ) )
-                   ;
-    throw std::runtime_error( msg );
+    if (attr.reprc == rep::ascii) {
+        dl::ascii tmp;
+        attr.into( tmp, allow_empty );
+        name = std::move( tmp );
+    }
+    else if (attr.reprc == rep::obname) {
+        dl::obname tmp;
+        attr.into( tmp, allow_empty );
+        name = std::move( tmp );
+    }
+    else
+        throw std::invalid_argument( "invalid reprc in LONG-NAME assign" );
 }
 
-const char* elements( const char* xs, dl::uvari count,
-                                      dl::representation_code reprc,
-                                      dl::value_vector& vec ) {
-    const auto n = static_cast< dl::uvari::value_type >( count );
-    dl::value_vector tmp = values_from_reprc( reprc );
-    copy_elements vs{ xs, n };
-    xs = boost::apply_visitor( vs, tmp );
-    vec.swap( tmp );
-    return xs;
 }
 
+namespace dl {
+
+value_vector::value_vector( representation_code reprc,
+                            std::int32_t count,
+                            const char* begin,
+                            const char* end ) noexcept (true) :
+    begin( begin ),
+    len( std::uint32_t( std::distance( begin, end ) ) ),
+    count( count ),
+    code( reprc )
+{}
+
+representation_code value_vector::reprc() const noexcept (true) {
+    return this->code;
 }
 
-namespace dl {
+std::size_t value_vector::size() const noexcept (true) {
+    return std::size_t( this->count );
+}
+
+bool value_vector::empty() const noexcept (true) {
+    return this->count == 0;
+}
+
+const char* value_vector::data() const noexcept (true) {
+    return this->begin;
+}
+
+std::size_t value_vector::bytes() const noexcept (true) {
+    return this->len;
+}
+
+template < typename T >
+void value_vector::get( std::vector< T >& out ) const noexcept (false) {
+    if (this->code != typeinfo< T >::reprc) {
+        const auto msg = "mismatching reprc (reprc = "
+                       + std::to_string( static_cast< int >( this->code ) )
+                       + "), expected "
+                       + std::to_string( static_cast< int >(
+                             typeinfo< T >::reprc ) )
+                       ;
+        throw std::invalid_argument( msg );
+    }
+
+    std::vector< T > tmp;
+    tmp.reserve( this->size() );
+
+    T elem;
+    auto xs = this->begin;
+    for( std::int32_t i = 0; i < this->count; ++i ) {
+        xs = cast( xs, elem );
+        tmp.push_back( std::move( elem ) );
+    }
+
+    out.swap( tmp );
+}
+
+#define DLIS_INSTANTIATE_GET(type) \
+    template void value_vector::get( std::vector< dl::type >& ) \
+    const noexcept (false);
+
+DLIS_INSTANTIATE_GET(fshort)
+DLIS_INSTANTIATE_GET(fsingl)
+DLIS_INSTANTIATE_GET(fsing1)
+DLIS_INSTANTIATE_GET(fsing2)
+DLIS_INSTANTIATE_GET(isingl)
+DLIS_INSTANTIATE_GET(vsingl)
+DLIS_INSTANTIATE_GET(fdoubl)
+DLIS_INSTANTIATE_GET(fdoub1)
+DLIS_INSTANTIATE_GET(fdoub2)
+DLIS_INSTANTIATE_GET(csingl)
+DLIS_INSTANTIATE_GET(cdoubl)
+DLIS_INSTANTIATE_GET(sshort)
+DLIS_INSTANTIATE_GET(snorm)
+DLIS_INSTANTIATE_GET(slong)
+DLIS_INSTANTIATE_GET(ushort)
+DLIS_INSTANTIATE_GET(unorm)
+DLIS_INSTANTIATE_GET(ulong)
+DLIS_INSTANTIATE_GET(uvari)
+DLIS_INSTANTIATE_GET(ident)
+DLIS_INSTANTIATE_GET(ascii)
+DLIS_INSTANTIATE_GET(dtime)
+DLIS_INSTANTIATE_GET(origin)
+DLIS_INSTANTIATE_GET(obname)
+DLIS_INSTANTIATE_GET(objref)
+DLIS_INSTANTIATE_GET(attref)
+DLIS_INSTANTIATE_GET(status)
+DLIS_INSTANTIATE_GET(units)
+
+#undef DLIS_INSTANTIATE_GET
 
 const std::string& basic_object::get_name() const noexcept (true) {
     return decay( this->object_name.id );
@@ -548,14 +780,20 @@ file_header&
 file_header::set( const object_attribute& attr, bool allow_empty )
 noexcept (false) {
     const auto& label = decay( attr.label );
+    using field = labels< file_header >::field;
 
-    if (label == "SEQUENCE-NUMBER") {
-        attr.into( this->sequence_number, allow_empty );
-    }
-    else if (label == "ID") {
-        attr.into( this->id, allow_empty );
+    switch (labels< file_header >::lookup( label )) {
+        case field::sequence_number:
+            attr.into( this->sequence_number, allow_empty );
+            break;
+
+        case field::id:
+            attr.into( this->id, allow_empty );
+            break;
+
+        case field::unknown:
+            throw std::invalid_argument( "unhandled label " + label );
     }
-    else throw std::invalid_argument( "unhandled label " + label );
 
     return *this;
 }
@@ -601,7 +839,8 @@ const char* parse_template( const char* cur,
         if (flags.count) cur = cast( cur, attr.count );
         if (flags.reprc) cur = cast( cur, attr.reprc );
         if (flags.units) cur = cast( cur, attr.units );
-        if (flags.value) cur = elements( cur, attr.count,
+        if (flags.value) cur = elements( cur, end,
+                                              attr.count,
                                               attr.reprc,
                                               attr.value );
         attr.invariant = flags.invariant;
@@ -613,81 +852,368 @@ const char* parse_template( const char* cur,
 channel& channel::set( const object_attribute& attr, bool allow_empty ) {
     using rep = dl::representation_code;
     const auto& label = decay( attr.label );
+    using field = labels< channel >::field;
 
-    if (label == "LONG-NAME") {
-        if (attr.reprc == rep::ascii)
-            attr.into( boost::get< dl::ascii >( this->name ), allow_empty );
-        else if (attr.reprc == rep::obname)
-            attr.into( boost::get< dl::obname >( this->name ), allow_empty );
-        else
-            throw std::invalid_argument(
-                "invalid reprc in channel LONG-NAME assign"
-            );
+    switch (labels< channel >::lookup( label )) {
+        case field::long_name:
+            long_name( attr, this->name, allow_empty );
+            break;
+
+        case field::properties:
+            attr.into( this->properties, allow_empty );
+            break;
+
+        case field::reprc:
+            attr.into( this->reprc, allow_empty );
+            break;
+
+        case field::units:
+            /*
+             * 5.5.1
+             * The standard specifies this to be units, but the example logical
+             * record has this as an ident (unspecified representation code)
+             *
+             * Since they're identical in representation (differ only in rule
+             * set), accept both after checking reprc
+             */
+
+            if (attr.reprc == rep::units) {
+                attr.into( this->units, allow_empty );
+            } else if (attr.reprc == rep::ident) {
+                dl::ident tmp;
+                attr.into( tmp, allow_empty );
+                this->units = dl::units{ dl::decay( tmp ) };
+            } else {
+                throw std::invalid_argument( "invalid reprc " +
+                    std::to_string( static_cast< std::uint8_t >( reprc ) ) );
+            }
+            break;
+
+        case field::dimension:
+            attr.into( this->dimension, allow_empty );
+            break;
+
+        case field::axis:
+            attr.into( this->axis, allow_empty );
+            break;
+
+        case field::element_limit:
+            attr.into( this->element_limit, allow_empty );
+            break;
+
+        case field::source:
+            attr.into( this->source, allow_empty );
+            break;
+
+        case field::unknown:
+            throw std::invalid_argument( "unhandled label " + label );
     }
 
-    else if (label == "ELEMENT-LIMIT") {
-        attr.into( this->element_limit, allow_empty );
+    return *this;
+}
+
+origin_object&
+origin_object::set( const object_attribute& attr, bool allow_empty )
+noexcept (false) {
+    const auto& label = decay( attr.label );
+    using field = labels< origin_object >::field;
+
+    switch (labels< origin_object >::lookup( label )) {
+        case field::file_id:
+            attr.into( this->file_id, allow_empty );
+            break;
+
+        case field::file_set_name:
+            attr.into( this->file_set_name, allow_empty );
+            break;
+
+        case field::file_set_number:
+            attr.into( this->file_set_number, allow_empty );
+            break;
+
+        case field::file_number:
+            attr.into( this->file_number, allow_empty );
+            break;
+
+        case field::file_type:
+            attr.into( this->file_type, allow_empty );
+            break;
+
+        case field::product:
+            attr.into( this->product, allow_empty );
+            break;
+
+        case field::version:
+            attr.into( this->version, allow_empty );
+            break;
+
+        case field::programs:
+            attr.into( this->programs, allow_empty );
+            break;
+
+        case field::creation_time:
+            attr.into( this->creation_time, allow_empty );
+            break;
+
+        case field::order_number:
+            attr.into( this->order_number, allow_empty );
+            break;
+
+        case field::descent_number:
+            attr.into( this->descent_number, allow_empty );
+            break;
+
+        case field::run_number:
+            attr.into( this->run_number, allow_empty );
+            break;
+
+        case field::well_id:
+            attr.into( this->well_id, allow_empty );
+            break;
+
+        case field::well_name:
+            attr.into( this->well_name, allow_empty );
+            break;
+
+        case field::field_name:
+            attr.into( this->field_name, allow_empty );
+            break;
+
+        case field::producer_code:
+            attr.into( this->producer_code, allow_empty );
+            break;
+
+        case field::producer_name:
+            attr.into( this->producer_name, allow_empty );
+            break;
+
+        case field::company:
+            attr.into( this->company, allow_empty );
+            break;
+
+        case field::namespace_name:
+            attr.into( this->namespace_name, allow_empty );
+            break;
+
+        case field::namespace_version:
+            attr.into( this->namespace_version, allow_empty );
+            break;
+
+        case field::unknown:
+            this->unknown.set( attr );
+            break;
     }
 
-    else if (label == "REPRESENTATION-CODE") {
-        attr.into( this->reprc, allow_empty );
+    return *this;
+}
+
+frame& frame::set( const object_attribute& attr, bool allow_empty ) {
+    const auto& label = decay( attr.label );
+    using field = labels< frame >::field;
+
+    switch (labels< frame >::lookup( label )) {
+        case field::description:
+            attr.into( this->description, allow_empty );
+            break;
+
+        case field::channels:
+            attr.into( this->channels, allow_empty );
+            break;
+
+        case field::index_type:
+            attr.into( this->index_type, allow_empty );
+            break;
+
+        case field::direction:
+            attr.into( this->direction, allow_empty );
+            break;
+
+        case field::spacing:
+            attr.into( this->spacing, allow_empty );
+            break;
+
+        case field::encrypted:
+            attr.into( this->encrypted, allow_empty );
+            break;
+
+        case field::index_min:
+            attr.into( this->index_min, allow_empty );
+            break;
+
+        case field::index_max:
+            attr.into( this->index_max, allow_empty );
+            break;
+
+        case field::unknown:
+            this->unknown.set( attr );
+            break;
     }
 
-    else if (label == "DIMENSION") {
-        attr.into( this->dimension, allow_empty );
+    return *this;
+}
+
+axis& axis::set( const object_attribute& attr, bool allow_empty ) {
+    const auto& label = decay( attr.label );
+    using field = labels< axis >::field;
+
+    switch (labels< axis >::lookup( label )) {
+        case field::axis_id:
+            attr.into( this->axis_id, allow_empty );
+            break;
+
+        case field::coordinates:
+            attr.into( this->coordinates, allow_empty );
+            break;
+
+        case field::spacing:
+            attr.into( this->spacing, allow_empty );
+            break;
+
+        case field::unknown:
+            this->unknown.set( attr );
+            break;
     }
 
-    else if (label == "UNITS") {
-        /*
-         * 5.5.1
-         * The standard specifies this to be units, but the example logical
-         * record has this as an ident (unspecified representation code)
-         *
-         * Since they're identical in representation (differ only in rule set),
-         * accept both after checking reprc
-         */
+    return *this;
+}
 
-        if (attr.reprc == rep::units) {
-            attr.into( this->units, allow_empty );
-        } else if (attr.reprc == rep::ident) {
-            dl::ident tmp;
-            attr.into( tmp, allow_empty );
-            this->units = dl::units{ dl::decay( tmp ) };
-        } else {
-            throw std::invalid_argument( "invalid reprc " +
-                    std::to_string( static_cast< std::uint8_t >( reprc ) ) );
-        }
+parameter& parameter::set( const object_attribute& attr, bool allow_empty ) {
+    const auto& label = decay( attr.label );
+    using field = labels< parameter >::field;
+
+    switch (labels< parameter >::lookup( label )) {
+        case field::long_name:
+            long_name( attr, this->name, allow_empty );
+            break;
+
+        case field::dimension:
+            attr.into( this->dimension, allow_empty );
+            break;
+
+        case field::axis:
+            attr.into( this->axis, allow_empty );
+            break;
+
+        case field::zones:
+            attr.into( this->zones, allow_empty );
+            break;
+
+        case field::values:
+            attr.into( this->values, allow_empty );
+            break;
+
+        case field::unknown:
+            this->unknown.set( attr );
+            break;
     }
 
-    else throw std::invalid_argument( "unhandled label " + label );
+    return *this;
+}
+
+zone& zone::set( const object_attribute& attr, bool allow_empty ) {
+    const auto& label = decay( attr.label );
+    using field = labels< zone >::field;
+
+    switch (labels< zone >::lookup( label )) {
+        case field::description:
+            attr.into( this->description, allow_empty );
+            break;
+
+        case field::domain:
+            attr.into( this->domain, allow_empty );
+            break;
+
+        case field::maximum:
+            attr.into( this->maximum, allow_empty );
+            break;
+
+        case field::minimum:
+            attr.into( this->minimum, allow_empty );
+            break;
+
+        case field::unknown:
+            this->unknown.set( attr );
+            break;
+    }
 
     return *this;
 }
 
+tool& tool::set( const object_attribute& attr, bool allow_empty ) {
+    const auto& label = decay( attr.label );
+    using field = labels< tool >::field;
+
+    switch (labels< tool >::lookup( label )) {
+        case field::description:
+            attr.into( this->description, allow_empty );
+            break;
+
+        case field::trademark_name:
+            attr.into( this->trademark_name, allow_empty );
+            break;
+
+        case field::generic_name:
+            attr.into( this->generic_name, allow_empty );
+            break;
+
+        case field::parts:
+            attr.into( this->parts, allow_empty );
+            break;
+
+        case field::status:
+            attr.into( this->status, allow_empty );
+            break;
+
+        case field::channels:
+            attr.into( this->channels, allow_empty );
+            break;
+
+        case field::parameters:
+            attr.into( this->parameters, allow_empty );
+            break;
+
+        case field::unknown:
+            this->unknown.set( attr );
+            break;
+    }
+
+    return *this;
+}
+
+void attribute_list::set( const object_attribute& attr ) noexcept (false) {
+    /*
+     * This is essentially map::insert-or-update
+     *
+     * Attributes are set in template order, and the attributes of an object
+     * are stored in template order, so the attribute to update is almost
+     * always the one after the previous update. Start the search there, and
+     * wrap around, which makes setting a full object linear rather than
+     * quadratic in the number of attributes.
+     */
+    const auto size = this->attributes.size();
+    for (std::size_t k = 0; k < size; ++k) {
+        const auto i = (this->hint + k) % size;
+        if (attr.label == this->attributes[i].label) {
+            this->attributes[i] = attr;
+            this->hint = i + 1;
+            return;
+        }
+    }
+
+    this->attributes.push_back(attr);
+    this->hint = this->attributes.size();
+}
+
 unknown_object&
 unknown_object::set( const object_attribute& attr, bool )
 noexcept (false)
 {
     /*
-     * This is essentially map::insert-or-update
-     *
      * The allow_empty argument can be ignored, because no semantics or
      * restrictions are considered for this unknown object. Consumers must
      * figure out if this is valid, non-null etc. -- just store what's read
      */
-    const auto eq = [&]( const object_attribute& x ) {
-        return attr.label == x.label;
-    };
-
-    auto itr = std::find_if( this->attributes.begin(),
-                             this->attributes.end(),
-                             eq );
-
-    if (itr == this->attributes.end())
-        this->attributes.push_back(attr);
-    else
-        *itr = attr;
-
+    this->attribute_list::set( attr );
     return *this;
 }
 
@@ -710,6 +1236,19 @@ object_vector parse_objects( const object_template& tmpl,
     std::vector< Object > objs;
     const auto default_object = defaulted_object< Object >( tmpl );
 
+    /*
+     * Objects only differ from the default object in the attributes they
+     * override, so an attribute with no count, reprc, units or value in the
+     * object is the template attribute, which is already set in the default,
+     * and is not touched at all.
+     *
+     * The overriding attribute is built in a single scratch attribute that is
+     * re-assigned from the template, rather than a fresh copy, so that the
+     * label and units strings re-use their buffers. The values are just views
+     * into the record, so they're cheap to copy.
+     */
+    object_attribute attr;
+
     while (true) {
         if (std::distance( cur, end ) <= 0)
             throw std::out_of_range( "unexpected end-of-record" );
@@ -717,7 +1256,8 @@ object_vector parse_objects( const object_template& tmpl,
         auto object_flags = parse_object_descriptor( cur );
         cur += DLIS_DESCRIPTOR_SIZE;
 
-        auto current = default_object;
+        objs.push_back( default_object );
+        auto& current = objs.back();
         if (object_flags.name) cur = cast( cur, current.object_name );
 
         for (const auto& template_attr : tmpl) {
@@ -734,9 +1274,9 @@ object_vector parse_objects( const object_template& tmpl,
              */
             cur += DLIS_DESCRIPTOR_SIZE;
 
-            auto attr = template_attr;
             // absent means no meaning, so *unset* whatever is there
             if (flags.absent) {
+                attr = template_attr;
                 attr.value = {};
                 current.set(attr, true);
                 continue;
@@ -746,18 +1286,27 @@ object_vector parse_objects( const object_template& tmpl,
                 user_warning( "ATTRIB:label set, but must be null");
             }
 
+            const auto overrides = flags.count
+                                || flags.reprc
+                                || flags.units
+                                || flags.value
+                                ;
+
+            if (!overrides) continue;
+
+            attr = template_attr;
+
             if (flags.count) cur = cast( cur, attr.count );
             if (flags.reprc) cur = cast( cur, attr.reprc );
             if (flags.units) cur = cast( cur, attr.units );
-            if (flags.value) cur = elements( cur, attr.count,
+            if (flags.value) cur = elements( cur, end,
+                                                  attr.count,
                                                   attr.reprc,
                                                   attr.value );
 
             current.set(attr);
         }
 
-        objs.push_back( std::move( current ) );
-
         if (cur == end) break;
     }
 
@@ -766,12 +1315,29 @@ object_vector parse_objects( const object_template& tmpl,
 
 }
 
-object_set parse_eflr( const char* cur, const char* end, int record_type ) {
+object_set parse_eflr( const char* cur,
+                       const char* end,
+                       int record_type ) {
     if (std::distance( cur, end ) <= 0)
         throw std::out_of_range( "eflr must be non-empty" );
 
     object_set set;
 
+    /*
+     * The attribute values are not decoded, but point into the record, so
+     * take a copy that lives as long as the set
+     */
+    const auto size = std::size_t( std::distance( cur, end ) );
+    auto* copy = new char[ size ];
+    std::memcpy( copy, cur, size );
+    set.record = std::shared_ptr< const char >(
+        copy,
+        std::default_delete< char[] >()
+    );
+
+    cur = set.record.get();
+    end = cur + size;
+
     const auto flags = parse_set_descriptor( cur );
     cur += DLIS_DESCRIPTOR_SIZE;
 
@@ -794,6 +1360,10 @@ object_set parse_eflr( const char* cur, const char* end, int record_type ) {
 
     std::string type = dl::decay( set.type );
     const auto& tmpl = set.tmpl;
+    const auto unknown = [&] {
+        return parse_objects< dl::unknown_object >( tmpl, cur, end );
+    };
+
     switch (record_type) {
         case DLIS_FHLR:
             if (type != "FILE-HEADER") {
@@ -803,8 +1373,27 @@ object_set parse_eflr( const char* cur, const char* end, int record_type ) {
             set.objects = parse_objects< dl::file_header >( tmpl, cur, end );
             break;
 
-        case DLIS_OLR: break;
-        case DLIS_AXIS: break;
+        /*
+         * The other record types can hold several set types, e.g. FRAME and
+         * PATH in FRAME records, so pick the object by the set type, and
+         * fall back to the unknown object for the ones without a typed object
+         */
+        case DLIS_OLR:
+            if (type == "ORIGIN")
+                set.objects = parse_objects< dl::origin_object >( tmpl,
+                                                                  cur,
+                                                                  end );
+            else
+                set.objects = unknown();
+            break;
+
+        case DLIS_AXIS:
+            if (type == "AXIS")
+                set.objects = parse_objects< dl::axis >( tmpl, cur, end );
+            else
+                set.objects = unknown();
+            break;
+
         case DLIS_CHANNL:
             if (type != "CHANNEL") {
                 user_warning( "segment is CHANNL, but object is " + type );
@@ -813,17 +1402,26 @@ object_set parse_eflr( const char* cur, const char* end, int record_type ) {
             set.objects = parse_objects< dl::channel >( tmpl, cur, end );
             break;
 
-        case DLIS_FRAME: break;
-        case DLIS_STATIC: break;
-        case DLIS_SCRIPT: break;
-        case DLIS_UPDATE: break;
-        case DLIS_UDI: break;
-        case DLIS_LNAME: break;
-        case DLIS_SPEC: break;
-        case DLIS_DICT: break;
+        case DLIS_FRAME:
+            if (type == "FRAME")
+                set.objects = parse_objects< dl::frame >( tmpl, cur, end );
+            else
+                set.objects = unknown();
+            break;
+
+        case DLIS_STATIC:
+            if (type == "PARAMETER")
+                set.objects = parse_objects< dl::parameter >( tmpl, cur, end );
+            else if (type == "ZONE")
+                set.objects = parse_objects< dl::zone >( tmpl, cur, end );
+            else if (type == "TOOL")
+                set.objects = parse_objects< dl::tool >( tmpl, cur, end );
+            else
+                set.objects = unknown();
+            break;
 
         default:
-            set.objects = parse_objects< dl::unknown_object >( tmpl, cur, end );
+            set.objects = unknown();
             break;
             /* use of reserved/undefined code */
             /* this is probably fine, but no more safety checks */
@@ -832,4 +1430,51 @@ object_set parse_eflr( const char* cur, const char* end, int record_type ) {
     return set;
 }
 
+std::size_t
+channel_index::hash::operator()( const obname& name ) const noexcept (true) {
+    const auto h1 = std::hash< std::string >()( decay( name.id ) );
+    const auto h2 = std::hash< std::int32_t >()( decay( name.origin ) );
+    const auto h3 = std::hash< std::uint8_t >()( name.copy );
+    return h1 ^ (h2 << 1) ^ (h3 << 2);
+}
+
+channel_index::channel_index( const std::vector< object_set >& sets )
+noexcept (false) {
+    for (const auto& set : sets) {
+        const auto* chs = boost::get< std::vector< channel > >( &set.objects );
+        if (!chs) continue;
+
+        for (const auto& ch : *chs)
+            this->channels.emplace( ch.object_name, &ch );
+    }
+}
+
+std::size_t channel_index::size() const noexcept (true) {
+    return this->channels.size();
+}
+
+const channel& channel_index::at( const obname& name ) const noexcept (false) {
+    const auto itr = this->channels.find( name );
+    if (itr == this->channels.end()) {
+        const auto msg = "no channel named ("
+                       + std::to_string( decay( name.origin ) ) + ", "
+                       + std::to_string( name.copy ) + ", "
+                       + decay( name.id ) + ")"
+                       ;
+        throw std::out_of_range( msg );
+    }
+
+    return *itr->second;
+}
+
+std::vector< const channel* > channel_index::resolve( const frame& f ) const
+noexcept (false) {
+    std::vector< const channel* > out;
+    out.reserve( f.channels.size() );
+    for (const auto& name : f.channels)
+        out.push_back( &this->at( name ) );
+
+    return out;
+}
+
 }
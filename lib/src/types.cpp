@@ -1,12 +1,23 @@
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <limits>
 #include <type_traits>
 
+#include <dlisio/dlisio.h>
 #include <dlisio/types.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define HAVE_X86_DISPATCH 1
+    #include <immintrin.h>
+    #define DLIS_TARGET( x ) __attribute__(( target( x ) ))
+#else
+    #define HAVE_X86_DISPATCH 0
+#endif
+
 namespace {
 
 /*
@@ -418,6 +429,894 @@ const char* dlis_units( const char* xs, std::int32_t* len, char* out ) {
     return xs + ln;
 }
 
+/*
+ * bulk decoders
+ *
+ * Curve data is mostly long runs of the same fixed-size type, so decoding is
+ * dominated by byteswapping. On little-endian hosts the buffer is swapped in
+ * blocks of 16, 32 or 64 bytes with pshufb, and the remaining tail with ntoh.
+ * The kernel is picked once, on first use, from what the running CPU
+ * supports. The shuffles are lane-local, so the same 16-byte mask is
+ * replicated across the wider registers.
+ */
+namespace {
+
+enum class isa { scalar, ssse3, avx2, avx512 };
+
+isa detect_isa() noexcept (true) {
+#if HAVE_X86_DISPATCH
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx512bw" ) ) return isa::avx512;
+    if( __builtin_cpu_supports( "avx2" ) )     return isa::avx2;
+    if( __builtin_cpu_supports( "ssse3" ) )    return isa::ssse3;
+#endif
+    return isa::scalar;
+}
+
+isa cpu_isa() noexcept (true) {
+    static const isa level = detect_isa();
+    return level;
+}
+
+template< typename T >
+void bswap_scalar( const char* xs, std::size_t n, T* out ) noexcept (true) {
+    for( std::size_t i = 0; i < n; ++i ) {
+        T x;
+        std::memcpy( &x, xs + i * sizeof( T ), sizeof( T ) );
+        out[ i ] = ntoh( x );
+    }
+}
+
+#if HAVE_X86_DISPATCH && !defined(HOST_BIG_ENDIAN)
+
+/*
+ * The mask reverses every width-sized group of bytes in a 16-byte lane
+ */
+template< int width >
+struct bswap_mask {
+    bswap_mask() noexcept (true) {
+        for( int i = 0; i < 16; ++i )
+            this->bytes[ i ] = char( (i / width) * width + (width - 1 - i % width) );
+    }
+
+    char bytes[ 16 ];
+};
+
+template< int width >
+const char* shuffle_mask() noexcept (true) {
+    static const bswap_mask< width > mask;
+    return mask.bytes;
+}
+
+DLIS_TARGET( "ssse3" )
+std::size_t bswap_ssse3( const char* xs,
+                         std::size_t len,
+                         char* out,
+                         const char* mask ) noexcept (true) {
+    const __m128i m = _mm_loadu_si128( (const __m128i*)mask );
+    std::size_t i = 0;
+    for( ; i + 16 <= len; i += 16 ) {
+        const __m128i x = _mm_loadu_si128( (const __m128i*)(xs + i) );
+        _mm_storeu_si128( (__m128i*)(out + i), _mm_shuffle_epi8( x, m ) );
+    }
+    return i;
+}
+
+DLIS_TARGET( "avx2" )
+std::size_t bswap_avx2( const char* xs,
+                        std::size_t len,
+                        char* out,
+                        const char* mask ) noexcept (true) {
+    const __m128i lane = _mm_loadu_si128( (const __m128i*)mask );
+    const __m256i m = _mm256_broadcastsi128_si256( lane );
+    std::size_t i = 0;
+    for( ; i + 32 <= len; i += 32 ) {
+        const __m256i x = _mm256_loadu_si256( (const __m256i*)(xs + i) );
+        _mm256_storeu_si256( (__m256i*)(out + i), _mm256_shuffle_epi8( x, m ) );
+    }
+    return i;
+}
+
+DLIS_TARGET( "avx512f,avx512bw" )
+std::size_t bswap_avx512( const char* xs,
+                          std::size_t len,
+                          char* out,
+                          const char* mask ) noexcept (true) {
+    /*
+     * _mm512_broadcast_i32x4 merges into _mm512_undefined_epi32(), which
+     * GCC flags with -Wuninitialized, so repeat the lane with set4 instead
+     */
+    std::int32_t lane[ 4 ];
+    std::memcpy( lane, mask, sizeof( lane ) );
+    const __m512i m = _mm512_set4_epi32( lane[ 3 ], lane[ 2 ],
+                                         lane[ 1 ], lane[ 0 ] );
+    std::size_t i = 0;
+    for( ; i + 64 <= len; i += 64 ) {
+        const __m512i x = _mm512_loadu_si512( (const void*)(xs + i) );
+        _mm512_storeu_si512( (void*)(out + i), _mm512_shuffle_epi8( x, m ) );
+    }
+    return i;
+}
+
+#endif
+
+template< typename T >
+const char* bswap_n( const char* xs, std::size_t n, T* out ) noexcept (true) {
+#ifdef HOST_BIG_ENDIAN
+    std::memcpy( out, xs, n * sizeof( T ) );
+#else
+    std::size_t done = 0;
+
+    #if HAVE_X86_DISPATCH
+    const auto len = n * sizeof( T );
+    const char* mask = shuffle_mask< sizeof( T ) >();
+    char* dst = reinterpret_cast< char* >( out );
+
+    switch( cpu_isa() ) {
+        case isa::avx512:
+            done = bswap_avx512( xs, len, dst, mask );
+            /* mop up the 16- and 32-byte blocks before the scalar tail */
+            done += bswap_avx2( xs + done, len - done, dst + done, mask );
+            done += bswap_ssse3( xs + done, len - done, dst + done, mask );
+            break;
+
+        case isa::avx2:
+            done = bswap_avx2( xs, len, dst, mask );
+            done += bswap_ssse3( xs + done, len - done, dst + done, mask );
+            break;
+
+        case isa::ssse3:
+            done = bswap_ssse3( xs, len, dst, mask );
+            break;
+
+        case isa::scalar:
+            break;
+    }
+
+    done /= sizeof( T );
+    #endif
+
+    bswap_scalar( xs + done * sizeof( T ), n - done, out + done );
+#endif
+    return xs + n * sizeof( T );
+}
+
+}
+
+const char* dlis_sshort_n( const char* xs, std::size_t n, std::int8_t* out ) {
+    std::memcpy( out, xs, n );
+    return xs + n;
+}
+
+const char* dlis_snorm_n( const char* xs, std::size_t n, std::int16_t* out ) {
+    return bswap_n( xs, n, out );
+}
+
+const char* dlis_slong_n( const char* xs, std::size_t n, std::int32_t* out ) {
+    return bswap_n( xs, n, out );
+}
+
+const char* dlis_ushort_n( const char* xs, std::size_t n, std::uint8_t* out ) {
+    std::memcpy( out, xs, n );
+    return xs + n;
+}
+
+const char* dlis_unorm_n( const char* xs, std::size_t n, std::uint16_t* out ) {
+    return bswap_n( xs, n, out );
+}
+
+const char* dlis_ulong_n( const char* xs, std::size_t n, std::uint32_t* out ) {
+    return bswap_n( xs, n, out );
+}
+
+const char* dlis_fsingl_n( const char* xs, std::size_t n, float* out ) {
+    return bswap_n( xs, n, out );
+}
+
+const char* dlis_fdoubl_n( const char* xs, std::size_t n, double* out ) {
+    return bswap_n( xs, n, out );
+}
+
+/*
+ * The IBM -> IEEE conversion of dlis_isingl, vectorised. The it/mt tables are
+ * only indexed by the top three bits of the mantissa, and both follow the
+ * number of leading zeros in those bits (clamped to 3): mt[ix] is 2^zeros and
+ * it[ix] is 0x20C00000 + zeros * 0x00400000. The lookups become three
+ * compares, and the multiplication by mt becomes up to three masked
+ * doublings, which keeps the result bit-for-bit identical to the scalar
+ * version, wrap-around included.
+ */
+namespace {
+
+#if HAVE_X86_DISPATCH && !defined(HOST_BIG_ENDIAN)
+
+DLIS_TARGET( "ssse3" )
+std::size_t isingl_ssse3( const char* xs,
+                          std::size_t n,
+                          float* out ) noexcept (true) {
+    const __m128i bswap    = _mm_loadu_si128(
+                                (const __m128i*)shuffle_mask< 4 >() );
+    const __m128i mantissa = _mm_set1_epi32( 0x00FFFFFF );
+    const __m128i exponent = _mm_set1_epi32( 0x7F000000 );
+    const __m128i absolute = _mm_set1_epi32( 0x7FFFFFFF );
+    const __m128i sign     = _mm_set1_epi32( std::int32_t( 0x80000000 ) );
+    const __m128i itbase   = _mm_set1_epi32( 0x20C00000 );
+    const __m128i itstep   = _mm_set1_epi32( 0x00400000 );
+    const __m128i iemaxib  = _mm_set1_epi32( 0x611FFFFF );
+    const __m128i ieminib  = _mm_set1_epi32( 0x21200000 );
+    const __m128i one      = _mm_set1_epi32( 1 );
+    const __m128i two      = _mm_set1_epi32( 2 );
+    const __m128i four     = _mm_set1_epi32( 4 );
+
+    std::size_t i = 0;
+    for( ; i + 4 <= n; i += 4 ) {
+        const __m128i raw = _mm_loadu_si128( (const __m128i*)(xs + 4 * i) );
+        const __m128i u = _mm_shuffle_epi8( raw, bswap );
+
+        __m128i manthi = _mm_and_si128( u, mantissa );
+        const __m128i ix = _mm_srli_epi32( manthi, 21 );
+        const __m128i lt4 = _mm_cmplt_epi32( ix, four );
+        const __m128i lt2 = _mm_cmplt_epi32( ix, two );
+        const __m128i lt1 = _mm_cmplt_epi32( ix, one );
+
+        __m128i it = itbase;
+        it = _mm_add_epi32( it, _mm_and_si128( lt4, itstep ) );
+        it = _mm_add_epi32( it, _mm_and_si128( lt2, itstep ) );
+        it = _mm_add_epi32( it, _mm_and_si128( lt1, itstep ) );
+
+        const __m128i iexp = _mm_slli_epi32(
+            _mm_sub_epi32( _mm_and_si128( u, exponent ), it ), 1 );
+
+        manthi = _mm_add_epi32( manthi, _mm_and_si128( manthi, lt4 ) );
+        manthi = _mm_add_epi32( manthi, _mm_and_si128( manthi, lt2 ) );
+        manthi = _mm_add_epi32( manthi, _mm_and_si128( manthi, lt1 ) );
+        manthi = _mm_add_epi32( manthi, iexp );
+
+        const __m128i inabs = _mm_and_si128( u, absolute );
+        const __m128i over  = _mm_cmpgt_epi32( inabs, iemaxib );
+        const __m128i under = _mm_cmplt_epi32( inabs, ieminib );
+
+        manthi = _mm_or_si128( _mm_and_si128( over, absolute ),
+                               _mm_andnot_si128( over, manthi ) );
+        manthi = _mm_or_si128( manthi, _mm_and_si128( u, sign ) );
+        manthi = _mm_andnot_si128( under, manthi );
+
+        _mm_storeu_si128( (__m128i*)(out + i), manthi );
+    }
+    return i;
+}
+
+DLIS_TARGET( "avx2" )
+std::size_t isingl_avx2( const char* xs,
+                         std::size_t n,
+                         float* out ) noexcept (true) {
+    const __m256i bswap    = _mm256_broadcastsi128_si256( _mm_loadu_si128(
+                                (const __m128i*)shuffle_mask< 4 >() ) );
+    const __m256i mantissa = _mm256_set1_epi32( 0x00FFFFFF );
+    const __m256i exponent = _mm256_set1_epi32( 0x7F000000 );
+    const __m256i absolute = _mm256_set1_epi32( 0x7FFFFFFF );
+    const __m256i sign     = _mm256_set1_epi32( std::int32_t( 0x80000000 ) );
+    const __m256i itbase   = _mm256_set1_epi32( 0x20C00000 );
+    const __m256i itstep   = _mm256_set1_epi32( 0x00400000 );
+    const __m256i iemaxib  = _mm256_set1_epi32( 0x611FFFFF );
+    const __m256i ieminib  = _mm256_set1_epi32( 0x21200000 );
+    const __m256i one      = _mm256_set1_epi32( 1 );
+    const __m256i two      = _mm256_set1_epi32( 2 );
+    const __m256i four     = _mm256_set1_epi32( 4 );
+
+    std::size_t i = 0;
+    for( ; i + 8 <= n; i += 8 ) {
+        const __m256i raw = _mm256_loadu_si256( (const __m256i*)(xs + 4 * i) );
+        const __m256i u = _mm256_shuffle_epi8( raw, bswap );
+
+        __m256i manthi = _mm256_and_si256( u, mantissa );
+        const __m256i ix = _mm256_srli_epi32( manthi, 21 );
+        const __m256i lt4 = _mm256_cmpgt_epi32( four, ix );
+        const __m256i lt2 = _mm256_cmpgt_epi32( two, ix );
+        const __m256i lt1 = _mm256_cmpgt_epi32( one, ix );
+
+        __m256i it = itbase;
+        it = _mm256_add_epi32( it, _mm256_and_si256( lt4, itstep ) );
+        it = _mm256_add_epi32( it, _mm256_and_si256( lt2, itstep ) );
+        it = _mm256_add_epi32( it, _mm256_and_si256( lt1, itstep ) );
+
+        const __m256i iexp = _mm256_slli_epi32(
+            _mm256_sub_epi32( _mm256_and_si256( u, exponent ), it ), 1 );
+
+        manthi = _mm256_add_epi32( manthi, _mm256_and_si256( manthi, lt4 ) );
+        manthi = _mm256_add_epi32( manthi, _mm256_and_si256( manthi, lt2 ) );
+        manthi = _mm256_add_epi32( manthi, _mm256_and_si256( manthi, lt1 ) );
+        manthi = _mm256_add_epi32( manthi, iexp );
+
+        const __m256i inabs = _mm256_and_si256( u, absolute );
+        const __m256i over  = _mm256_cmpgt_epi32( inabs, iemaxib );
+        const __m256i under = _mm256_cmpgt_epi32( ieminib, inabs );
+
+        manthi = _mm256_or_si256( _mm256_and_si256( over, absolute ),
+                                  _mm256_andnot_si256( over, manthi ) );
+        manthi = _mm256_or_si256( manthi, _mm256_and_si256( u, sign ) );
+        manthi = _mm256_andnot_si256( under, manthi );
+
+        _mm256_storeu_si256( (__m256i*)(out + i), manthi );
+    }
+    return i;
+}
+
+#endif
+
+}
+
+const char* dlis_isingl_n( const char* xs, std::size_t n, float* out ) {
+    std::size_t done = 0;
+
+#if HAVE_X86_DISPATCH && !defined(HOST_BIG_ENDIAN)
+    switch( cpu_isa() ) {
+        case isa::avx512:
+        case isa::avx2:
+            done = isingl_avx2( xs, n, out );
+            done += isingl_ssse3( xs + 4 * done, n - done, out + done );
+            break;
+
+        case isa::ssse3:
+            done = isingl_ssse3( xs, n, out );
+            break;
+
+        case isa::scalar:
+            break;
+    }
+#endif
+
+    for( ; done < n; ++done )
+        dlis_isingl( xs + 4 * done, out + done );
+
+    return xs + n * sizeof( std::uint32_t );
+}
+
+/*
+ * FSHORT and VSINGL without std::pow. Both are built by injecting the
+ * exponent directly into the bits of an IEEE float.
+ *
+ * FSHORT is a 12-bit two's complement fraction and a 4-bit exponent, so the
+ * value is the sign-extended fraction m, scaled by 2^(exp - 11). Both the
+ * conversion of m and the multiplication are exact.
+ *
+ * VSINGL is decoded like dlis_vsingl, i.e. (0.5 + frac / 2^23) * 2^(exp - 128).
+ * The significand is at most 24 bits, so it's exactly converted to a float,
+ * and the power of two is built from the exponent bits (a denormal for
+ * exp == 1). Only the final multiplication rounds, like the scalar version
+ * does. A zero exponent is zero or, with the sign bit set, the reserved
+ * operand (NaN).
+ */
+namespace {
+
+float fshort_lane( std::uint16_t v ) noexcept (true) {
+    const std::int32_t m = ((std::int32_t( v & 0xFFF0 ) ^ 0x8000) - 0x8000) / 16;
+    const std::uint32_t scale = ((v & 0x000F) + 116) << 23;
+
+    float s;
+    std::memcpy( &s, &scale, sizeof( s ) );
+    return float( m ) * s;
+}
+
+float vsingl_lane( std::uint32_t v, float reserved ) noexcept (true) {
+    const std::uint32_t exp_bits = (v >> 23) & 0xFF;
+    const std::uint32_t sign_bit = v & 0x80000000;
+    const std::uint32_t frac_bits = v & 0x007FFFFF;
+
+    if( exp_bits == 0 )
+        return sign_bit ? reserved : 0.0f;
+
+    const std::uint32_t scale = exp_bits == 1 ? 0x00400000
+                                              : (exp_bits - 1) << 23;
+    float s;
+    std::memcpy( &s, &scale, sizeof( s ) );
+
+    const float significand = float( frac_bits + 0x00400000 ) / 0x00800000;
+    float x = significand * s;
+
+    std::uint32_t bits;
+    std::memcpy( &bits, &x, sizeof( bits ) );
+    bits |= sign_bit;
+    std::memcpy( &x, &bits, sizeof( x ) );
+    return x;
+}
+
+#if HAVE_X86_DISPATCH && !defined(HOST_BIG_ENDIAN)
+
+DLIS_TARGET( "ssse3" )
+std::size_t fshort_ssse3( const char* xs,
+                          std::size_t n,
+                          float* out ) noexcept (true) {
+    const __m128i bswap = _mm_loadu_si128(
+                            (const __m128i*)shuffle_mask< 2 >() );
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i low4  = _mm_set1_epi32( 0x000F );
+    const __m128i bias  = _mm_set1_epi32( 116 );
+
+    std::size_t i = 0;
+    for( ; i + 8 <= n; i += 8 ) {
+        const __m128i raw = _mm_loadu_si128( (const __m128i*)(xs + 2 * i) );
+        const __m128i v = _mm_shuffle_epi8( raw, bswap );
+
+        /* widen to 32 bits, with the value in the upper half of the lane */
+        const __m128i halves[] = { _mm_unpacklo_epi16( zero, v ),
+                                   _mm_unpackhi_epi16( zero, v ) };
+
+        for( int k = 0; k < 2; ++k ) {
+            const __m128i x = halves[ k ];
+            const __m128i m = _mm_srai_epi32( x, 20 );
+            const __m128i e = _mm_and_si128( _mm_srli_epi32( x, 16 ), low4 );
+            const __m128i s = _mm_slli_epi32( _mm_add_epi32( e, bias ), 23 );
+            const __m128 r = _mm_mul_ps( _mm_cvtepi32_ps( m ),
+                                         _mm_castsi128_ps( s ) );
+            _mm_storeu_ps( out + i + 4 * k, r );
+        }
+    }
+    return i;
+}
+
+DLIS_TARGET( "avx2" )
+std::size_t fshort_avx2( const char* xs,
+                         std::size_t n,
+                         float* out ) noexcept (true) {
+    const __m128i bswap = _mm_loadu_si128(
+                            (const __m128i*)shuffle_mask< 2 >() );
+    const __m256i low4  = _mm256_set1_epi32( 0x000F );
+    const __m256i bias  = _mm256_set1_epi32( 116 );
+
+    std::size_t i = 0;
+    for( ; i + 8 <= n; i += 8 ) {
+        const __m128i raw = _mm_loadu_si128( (const __m128i*)(xs + 2 * i) );
+        const __m128i v = _mm_shuffle_epi8( raw, bswap );
+        const __m256i x = _mm256_slli_epi32( _mm256_cvtepu16_epi32( v ), 16 );
+
+        const __m256i m = _mm256_srai_epi32( x, 20 );
+        const __m256i e = _mm256_and_si256( _mm256_srli_epi32( x, 16 ), low4 );
+        const __m256i s = _mm256_slli_epi32( _mm256_add_epi32( e, bias ), 23 );
+        const __m256 r = _mm256_mul_ps( _mm256_cvtepi32_ps( m ),
+                                        _mm256_castsi256_ps( s ) );
+        _mm256_storeu_ps( out + i, r );
+    }
+    return i;
+}
+
+DLIS_TARGET( "ssse3" )
+std::size_t vsingl_ssse3( const char* xs,
+                          std::size_t n,
+                          float* out,
+                          float reserved ) noexcept (true) {
+    const __m128i byte   = _mm_set1_epi32( 0xFF );
+    const __m128i one    = _mm_set1_epi32( 1 );
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i sign   = _mm_set1_epi32( std::int32_t( 0x80000000 ) );
+    const __m128i frac   = _mm_set1_epi32( 0x007FFFFF );
+    const __m128i half   = _mm_set1_epi32( 0x00400000 );
+    const __m128  ulp    = _mm_set1_ps( 1.0f / 0x00800000 );
+    const __m128i nan    = _mm_castps_si128( _mm_set1_ps( reserved ) );
+
+    std::size_t i = 0;
+    for( ; i + 4 <= n; i += 4 ) {
+        /* on little-endian, swapping the 16-bit halves is all that's needed */
+        const __m128i raw = _mm_loadu_si128( (const __m128i*)(xs + 4 * i) );
+        const __m128i v = _mm_or_si128( _mm_slli_epi32( raw, 16 ),
+                                        _mm_srli_epi32( raw, 16 ) );
+
+        const __m128i e  = _mm_and_si128( _mm_srli_epi32( v, 23 ), byte );
+        const __m128i sb = _mm_and_si128( v, sign );
+        const __m128i e0 = _mm_cmpeq_epi32( e, zero );
+        const __m128i e1 = _mm_cmpeq_epi32( e, one );
+
+        const __m128 significand = _mm_mul_ps( ulp, _mm_cvtepi32_ps(
+                _mm_add_epi32( _mm_and_si128( v, frac ), half ) ) );
+
+        const __m128i normal = _mm_slli_epi32( _mm_sub_epi32( e, one ), 23 );
+        const __m128i scale  = _mm_or_si128( _mm_and_si128( e1, half ),
+                                             _mm_andnot_si128( e1, normal ) );
+
+        __m128i r = _mm_castps_si128(
+                _mm_mul_ps( significand, _mm_castsi128_ps( scale ) ) );
+        r = _mm_or_si128( r, sb );
+
+        /* e == 0 is +0, or the reserved operand when the sign is set */
+        const __m128i zeroexp = _mm_and_si128( _mm_cmpeq_epi32( sb, sign ),
+                                               nan );
+        r = _mm_or_si128( _mm_and_si128( e0, zeroexp ),
+                          _mm_andnot_si128( e0, r ) );
+
+        _mm_storeu_si128( (__m128i*)(out + i), r );
+    }
+    return i;
+}
+
+DLIS_TARGET( "avx2" )
+std::size_t vsingl_avx2( const char* xs,
+                         std::size_t n,
+                         float* out,
+                         float reserved ) noexcept (true) {
+    const __m256i byte   = _mm256_set1_epi32( 0xFF );
+    const __m256i one    = _mm256_set1_epi32( 1 );
+    const __m256i zero   = _mm256_setzero_si256();
+    const __m256i sign   = _mm256_set1_epi32( std::int32_t( 0x80000000 ) );
+    const __m256i frac   = _mm256_set1_epi32( 0x007FFFFF );
+    const __m256i half   = _mm256_set1_epi32( 0x00400000 );
+    const __m256  ulp    = _mm256_set1_ps( 1.0f / 0x00800000 );
+    const __m256i nan    = _mm256_castps_si256( _mm256_set1_ps( reserved ) );
+
+    std::size_t i = 0;
+    for( ; i + 8 <= n; i += 8 ) {
+        const __m256i raw = _mm256_loadu_si256( (const __m256i*)(xs + 4 * i) );
+        const __m256i v = _mm256_or_si256( _mm256_slli_epi32( raw, 16 ),
+                                           _mm256_srli_epi32( raw, 16 ) );
+
+        const __m256i e  = _mm256_and_si256( _mm256_srli_epi32( v, 23 ), byte );
+        const __m256i sb = _mm256_and_si256( v, sign );
+        const __m256i e0 = _mm256_cmpeq_epi32( e, zero );
+        const __m256i e1 = _mm256_cmpeq_epi32( e, one );
+
+        const __m256 significand = _mm256_mul_ps( ulp, _mm256_cvtepi32_ps(
+                _mm256_add_epi32( _mm256_and_si256( v, frac ), half ) ) );
+
+        const __m256i normal = _mm256_slli_epi32(
+                                    _mm256_sub_epi32( e, one ), 23 );
+        const __m256i scale  = _mm256_or_si256(
+                                    _mm256_and_si256( e1, half ),
+                                    _mm256_andnot_si256( e1, normal ) );
+
+        __m256i r = _mm256_castps_si256(
+                _mm256_mul_ps( significand, _mm256_castsi256_ps( scale ) ) );
+        r = _mm256_or_si256( r, sb );
+
+        const __m256i zeroexp = _mm256_and_si256(
+                                    _mm256_cmpeq_epi32( sb, sign ), nan );
+        r = _mm256_or_si256( _mm256_and_si256( e0, zeroexp ),
+                             _mm256_andnot_si256( e0, r ) );
+
+        _mm256_storeu_si256( (__m256i*)(out + i), r );
+    }
+    return i;
+}
+
+#endif
+
+}
+
+const char* dlis_fshort_n( const char* xs, std::size_t n, float* out ) {
+    std::size_t done = 0;
+
+#if HAVE_X86_DISPATCH && !defined(HOST_BIG_ENDIAN)
+    switch( cpu_isa() ) {
+        case isa::avx512:
+        case isa::avx2:
+            done = fshort_avx2( xs, n, out );
+            break;
+
+        case isa::ssse3:
+            done = fshort_ssse3( xs, n, out );
+            break;
+
+        case isa::scalar:
+            break;
+    }
+#endif
+
+    for( ; done < n; ++done ) {
+        std::uint16_t v;
+        std::memcpy( &v, xs + 2 * done, sizeof( v ) );
+        out[ done ] = fshort_lane( ntoh( v ) );
+    }
+
+    return xs + n * sizeof( std::uint16_t );
+}
+
+const char* dlis_vsingl_n( const char* xs, std::size_t n, float* out ) {
+    const float reserved = std::nanf( "" );
+    std::size_t done = 0;
+
+#if HAVE_X86_DISPATCH && !defined(HOST_BIG_ENDIAN)
+    switch( cpu_isa() ) {
+        case isa::avx512:
+        case isa::avx2:
+            done = vsingl_avx2( xs, n, out, reserved );
+            done += vsingl_ssse3( xs + 4 * done, n - done, out + done,
+                                  reserved );
+            break;
+
+        case isa::ssse3:
+            done = vsingl_ssse3( xs, n, out, reserved );
+            break;
+
+        case isa::scalar:
+            break;
+    }
+#endif
+
+    for( ; done < n; ++done ) {
+        const auto* x = reinterpret_cast< const unsigned char* >( xs )
+                      + 4 * done;
+        const std::uint32_t v = std::uint32_t(x[1]) << 24
+                              | std::uint32_t(x[0]) << 16
+                              | std::uint32_t(x[3]) << 8
+                              | std::uint32_t(x[2]) << 0
+                              ;
+        out[ done ] = vsingl_lane( v, reserved );
+    }
+
+    return xs + n * sizeof( std::uint32_t );
+}
+
+namespace {
+
+/*
+ * Gather the channel bytes of as many frames as fits into a small staging
+ * buffer, and decode the buffer with a single bulk call. When the frames are
+ * back-to-back the channel is already contiguous, and when the channel
+ * itself is large it's decoded in place, frame by frame.
+ *
+ * width is the size of a single (scalar) value, and values the number of
+ * values per frame, i.e. count times the number of components of the
+ * representation code.
+ */
+template< typename T, typename Bulk >
+void decode_strided( Bulk bulk,
+                     std::size_t width,
+                     const char* base,
+                     std::size_t stride,
+                     std::size_t offset,
+                     std::size_t values,
+                     std::size_t nframes,
+                     void* dst ) noexcept (true) {
+    T* out = static_cast< T* >( dst );
+    const std::size_t len = values * width;
+    if( len == 0 ) return;
+
+    if( stride == len ) {
+        bulk( base + offset, values * nframes, out );
+        return;
+    }
+
+    char staging[ 4096 ];
+    const std::size_t perblock = sizeof( staging ) / len;
+
+    if( perblock < 16 ) {
+        for( std::size_t i = 0; i < nframes; ++i )
+            bulk( base + i * stride + offset, values, out + i * values );
+        return;
+    }
+
+    for( std::size_t i = 0; i < nframes; i += perblock ) {
+        const std::size_t frames = std::min( perblock, nframes - i );
+        const char* src = base + i * stride + offset;
+        for( std::size_t k = 0; k < frames; ++k )
+            std::memcpy( staging + k * len, src + k * stride, len );
+
+        bulk( staging, frames * values, out + i * values );
+    }
+}
+
+}
+
+int dlis_decode_strided( int reprc,
+                         const char* base,
+                         std::size_t stride,
+                         std::size_t offset,
+                         std::size_t count,
+                         std::size_t nframes,
+                         void* out ) {
+    const auto n = count;
+    switch( reprc ) {
+        case DLIS_FSHORT: decode_strided< float >( dlis_fshort_n, 2,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_FSINGL: decode_strided< float >( dlis_fsingl_n, 4,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_FSING1: decode_strided< float >( dlis_fsingl_n, 4,
+                            base, stride, offset, 2 * n, nframes, out ); break;
+        case DLIS_FSING2: decode_strided< float >( dlis_fsingl_n, 4,
+                            base, stride, offset, 3 * n, nframes, out ); break;
+        case DLIS_ISINGL: decode_strided< float >( dlis_isingl_n, 4,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_VSINGL: decode_strided< float >( dlis_vsingl_n, 4,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_FDOUBL: decode_strided< double >( dlis_fdoubl_n, 8,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_FDOUB1: decode_strided< double >( dlis_fdoubl_n, 8,
+                            base, stride, offset, 2 * n, nframes, out ); break;
+        case DLIS_FDOUB2: decode_strided< double >( dlis_fdoubl_n, 8,
+                            base, stride, offset, 3 * n, nframes, out ); break;
+        case DLIS_CSINGL: decode_strided< float >( dlis_fsingl_n, 4,
+                            base, stride, offset, 2 * n, nframes, out ); break;
+        case DLIS_CDOUBL: decode_strided< double >( dlis_fdoubl_n, 8,
+                            base, stride, offset, 2 * n, nframes, out ); break;
+        case DLIS_SSHORT: decode_strided< std::int8_t >( dlis_sshort_n, 1,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_SNORM:  decode_strided< std::int16_t >( dlis_snorm_n, 2,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_SLONG:  decode_strided< std::int32_t >( dlis_slong_n, 4,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_USHORT: decode_strided< std::uint8_t >( dlis_ushort_n, 1,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_UNORM:  decode_strided< std::uint16_t >( dlis_unorm_n, 2,
+                            base, stride, offset, n, nframes, out ); break;
+        case DLIS_ULONG:  decode_strided< std::uint32_t >( dlis_ulong_n, 4,
+                            base, stride, offset, n, nframes, out ); break;
+
+        default:
+            return -1;
+    }
+
+    return 0;
+}
+
+namespace {
+
+/*
+ * The skip kernels only read the length prefixes. The uvari encodes its own
+ * length in the two high bits, and ident is prefixed by a ushort length
+ */
+std::size_t uvari_length( const char* xs ) noexcept (true) {
+    switch( std::uint8_t( xs[ 0 ] ) & 0xC0 ) {
+        case 0xC0: return 4;
+        case 0x80: return 2;
+        default:   return 1;
+    }
+}
+
+const char* skip_uvari( const char* xs ) noexcept (true) {
+    return xs + uvari_length( xs );
+}
+
+const char* skip_ident( const char* xs ) noexcept (true) {
+    return xs + 1 + std::uint8_t( xs[ 0 ] );
+}
+
+const char* skip_ascii( const char* xs ) noexcept (true) {
+    std::int32_t len;
+    xs = dlis_uvari( xs, &len );
+    return xs + len;
+}
+
+const char* skip_obname( const char* xs ) noexcept (true) {
+    /* origin, copy number, identifier */
+    return skip_ident( skip_uvari( xs ) + 1 );
+}
+
+const char* skip_objref( const char* xs ) noexcept (true) {
+    return skip_obname( skip_ident( xs ) );
+}
+
+const char* skip_attref( const char* xs ) noexcept (true) {
+    return skip_ident( skip_obname( skip_ident( xs ) ) );
+}
+
+template< typename Skip >
+const char* skip_n( Skip skip, const char* xs, std::size_t n ) noexcept (true) {
+    for( std::size_t i = 0; i < n; ++i )
+        xs = skip( xs );
+    return xs;
+}
+
+/*
+ * The bounded kernels check every length prefix against end before reading
+ * it, and return nullptr as soon as something does not fit
+ */
+const char* bounded_uvari( const char* xs, const char* end ) noexcept (true) {
+    if( !xs || xs >= end ) return nullptr;
+    const auto len = uvari_length( xs );
+    if( std::size_t( end - xs ) < len ) return nullptr;
+    return xs + len;
+}
+
+const char* bounded_ident( const char* xs, const char* end ) noexcept (true) {
+    if( !xs || xs >= end ) return nullptr;
+    const auto len = std::size_t( std::uint8_t( xs[ 0 ] ) );
+    if( std::size_t( end - xs ) - 1 < len ) return nullptr;
+    return xs + 1 + len;
+}
+
+const char* bounded_ascii( const char* xs, const char* end ) noexcept (true) {
+    const char* body = bounded_uvari( xs, end );
+    if( !body ) return nullptr;
+
+    std::int32_t len;
+    dlis_uvari( xs, &len );
+    if( end - body < len ) return nullptr;
+    return body + len;
+}
+
+const char* bounded_obname( const char* xs, const char* end ) noexcept (true) {
+    /* origin, copy number, identifier */
+    const char* copy = bounded_uvari( xs, end );
+    if( !copy || copy >= end ) return nullptr;
+    return bounded_ident( copy + 1, end );
+}
+
+const char* bounded_objref( const char* xs, const char* end ) noexcept (true) {
+    return bounded_obname( bounded_ident( xs, end ), end );
+}
+
+const char* bounded_attref( const char* xs, const char* end ) noexcept (true) {
+    return bounded_ident( bounded_obname( bounded_ident( xs, end ), end ), end );
+}
+
+template< typename Skip >
+const char* bounded_n( Skip skip,
+                       const char* xs,
+                       const char* end,
+                       std::size_t n ) noexcept (true) {
+    for( std::size_t i = 0; i < n && xs; ++i )
+        xs = skip( xs, end );
+    return xs;
+}
+
+}
+
+const char* dlis_skip( int reprc, const char* xs, std::size_t n ) {
+    const int size = dlis_sizeof_type( reprc );
+    if( size < 0 ) return nullptr;
+    if( size > 0 ) return xs + n * size;
+
+    switch( reprc ) {
+        case DLIS_UVARI:
+        case DLIS_ORIGIN: return skip_n( skip_uvari,  xs, n );
+        case DLIS_IDENT:
+        case DLIS_UNITS:  return skip_n( skip_ident,  xs, n );
+        case DLIS_ASCII:  return skip_n( skip_ascii,  xs, n );
+        case DLIS_OBNAME: return skip_n( skip_obname, xs, n );
+        case DLIS_OBJREF: return skip_n( skip_objref, xs, n );
+        case DLIS_ATTREF: return skip_n( skip_attref, xs, n );
+
+        default:
+            return nullptr;
+    }
+}
+
+const char* dlis_skip_bounded( int reprc,
+                               const char* xs,
+                               const char* end,
+                               std::size_t n ) {
+    const int size = dlis_sizeof_type( reprc );
+    if( size < 0 ) return nullptr;
+    if( xs > end ) return nullptr;
+    if( size > 0 ) {
+        if( std::size_t( end - xs ) / size < n ) return nullptr;
+        return xs + n * size;
+    }
+
+    switch( reprc ) {
+        case DLIS_UVARI:
+        case DLIS_ORIGIN: return bounded_n( bounded_uvari,  xs, end, n );
+        case DLIS_IDENT:
+        case DLIS_UNITS:  return bounded_n( bounded_ident,  xs, end, n );
+        case DLIS_ASCII:  return bounded_n( bounded_ascii,  xs, end, n );
+        case DLIS_OBNAME: return bounded_n( bounded_obname, xs, end, n );
+        case DLIS_OBJREF: return bounded_n( bounded_objref, xs, end, n );
+        case DLIS_ATTREF: return bounded_n( bounded_attref, xs, end, n );
+
+        default:
+            return nullptr;
+    }
+}
+
+int dlis_frame_offsets( const char* xs,
+                        const char* end,
+                        std::size_t nchannels,
+                        const std::int32_t* counts,
+                        const std::int32_t* reprcs,
+                        std::size_t* offsets ) {
+    const char* ptr = xs;
+    for( std::size_t i = 0; i < nchannels; ++i ) {
+        offsets[ i ] = std::size_t( ptr - xs );
+
+        if( counts[ i ] < 0 ) return DLIS_UNEXPECTED_VALUE;
+        if( dlis_sizeof_type( reprcs[ i ] ) < 0 ) return DLIS_UNEXPECTED_VALUE;
+
+        ptr = dlis_skip_bounded( reprcs[ i ], ptr, end, counts[ i ] );
+        if( !ptr ) return DLIS_TRUNCATED;
+    }
+
+    offsets[ nchannels ] = std::size_t( ptr - xs );
+    return DLIS_OK;
+}
+
 /*
  * output functions
  */
@@ -1,14 +1,26 @@
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
 #include <tuple>
 
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/stat.h>
+#endif
+
 #include <catch2/catch.hpp>
 
 #include <dlisio/dlisio.h>
 #include <dlisio/types.h>
 #include <dlisio/ext/io.hpp>
 
+#include "tempfile.hpp"
+
 using filestream = dl::basic_file< std::stringstream >;
 
 void write_vrl( filestream& fs, int len ) {
@@ -272,3 +284,778 @@ TEST_CASE("IFRL obname split across two VRLs") {
     CHECK( x.second.name == expected_name );
     CHECK( fs.tell() == last );
 }
+
+TEST_CASE("IFLR read from memory-mapped file") {
+    std::array< char, 100 > body = {};
+    const auto name = iflr();
+
+    const auto last = body.size() + name.size()
+                    + DLIS_LRSH_SIZE
+                    + DLIS_VRL_SIZE
+                    ;
+
+    filestream out;
+    write_vrl( out, last - DLIS_VRL_SIZE );
+    write_iflr_segment( out, name.size() + body.size() );
+    out.write( name.data(), name.size() );
+    out.write( body.data(), body.size() );
+    const temp_file file( "mapped-file-iflr.dlis", out.read( last ) );
+
+    dl::mapped_file fs( file.path );
+    CHECK( fs.size() == last );
+    CHECK( !fs.eof() );
+
+    dl::obname expected_name {
+        dl::origin{ 1 },
+        1,
+        dl::ident{ "iflr" },
+    };
+
+    const auto x = dl::tag( fs, 0 );
+    CHECK( x.first == 0 );
+    CHECK( x.second.name == expected_name );
+    CHECK( fs.tell() == last );
+    CHECK( fs.eof() );
+
+    SECTION("views point into the mapping") {
+        fs.seek( DLIS_VRL_SIZE + DLIS_LRSH_SIZE );
+        const auto* ptr = fs.view( name.size() );
+        CHECK( ptr == fs.data() + DLIS_VRL_SIZE + DLIS_LRSH_SIZE );
+        CHECK( std::memcmp( ptr, name.data(), name.size() ) == 0 );
+    }
+
+    SECTION("reading past end-of-file throws") {
+        fs.seek( last - 2 );
+        CHECK_THROWS_AS( fs.read< 4 >(), std::out_of_range );
+    }
+}
+
+TEST_CASE("Record view of segmented record with trailers") {
+    std::array< char, 10 > fst;
+    std::array< char, 6 > snd;
+    std::iota( fst.begin(), fst.end(), 0 );
+    std::iota( snd.begin(), snd.end(), fst.size() );
+
+    /* 3 bytes of padding, then checksum and trailing length */
+    const std::array< char, 7 > trailer = { 0, 0, 3, 0, 0, 0, 0 };
+    const auto attrs = DLIS_SEGATTR_SUCCSEG
+                     | DLIS_SEGATTR_PADDING
+                     | DLIS_SEGATTR_CHCKSUM
+                     | DLIS_SEGATTR_TRAILEN
+                     ;
+
+    const auto vrlen = 2 * DLIS_LRSH_SIZE
+                     + fst.size() + trailer.size()
+                     + snd.size()
+                     ;
+
+    filestream out;
+    write_vrl( out, vrlen );
+    write_iflr_segment( out, fst.size() + trailer.size(), attrs );
+    out.write( fst.data(), fst.size() );
+    out.write( trailer.data(), trailer.size() );
+    write_iflr_segment( out, snd.size() );
+    out.write( snd.data(), snd.size() );
+    const temp_file file( "mapped-file-segmented.dlis",
+                          out.read( vrlen + DLIS_VRL_SIZE ) );
+
+    dl::mapped_file fs( file.path );
+    dl::record_view record;
+    dl::view_record( fs, 0, record );
+
+    CHECK( fs.eof() );
+    CHECK( !record.contiguous() );
+    REQUIRE( record.segments.size() == 2 );
+    CHECK( record.segments[ 0 ].size == fst.size() );
+    CHECK( record.segments[ 1 ].size == snd.size() );
+    CHECK( record.size() == fst.size() + snd.size() );
+
+    std::vector< char > expected( fst.begin(), fst.end() );
+    expected.insert( expected.end(), snd.begin(), snd.end() );
+
+    std::vector< char > buffer;
+    const auto* ptr = record.data( buffer );
+    CHECK( std::vector< char >( ptr, ptr + record.size() ) == expected );
+
+    SECTION("unsegmented records are not copied") {
+        fs.seek( DLIS_VRL_SIZE + DLIS_LRSH_SIZE
+                 + fst.size() + trailer.size() );
+        dl::view_record( fs, snd.size() + DLIS_LRSH_SIZE, record );
+        buffer.clear();
+
+        REQUIRE( record.contiguous() );
+        CHECK( record.data( buffer ) == record.segments[ 0 ].data );
+        CHECK( buffer.empty() );
+    }
+
+    SECTION("slices within a segment are not copied") {
+        buffer.clear();
+        CHECK( record.slice( 2, 5, buffer ) == record.segments[ 0 ].data + 2 );
+        CHECK( record.slice( 11, 3, buffer ) == record.segments[ 1 ].data + 1 );
+        CHECK( buffer.empty() );
+    }
+
+    SECTION("slices across segments are gathered") {
+        const auto* slice = record.slice( 7, 6, buffer );
+        const auto first = expected.begin() + 7;
+        CHECK( std::vector< char >( slice, slice + 6 )
+            == std::vector< char >( first, first + 6 ) );
+    }
+
+    SECTION("slices past the end throw") {
+        CHECK_THROWS_AS( record.slice( 12, 5, buffer ), std::out_of_range );
+        CHECK_THROWS_AS( record.slice( 17, 1, buffer ), std::out_of_range );
+    }
+}
+
+namespace {
+
+struct logical_record {
+    bool isexplicit;
+    std::string name;
+    int bodylen;
+};
+
+/*
+ * Write the logical records into visible records of at most vrmax bytes,
+ * splitting records into segments as needed. Bodies are filled with a pattern
+ * that often looks like visible record labels.
+ */
+std::vector< char > write_records( const std::vector< logical_record >& recs,
+                                   int vrmax ) {
+    std::vector< char > file;
+    std::vector< char > vr;
+
+    const auto flush = [&] {
+        std::array< char, DLIS_VRL_SIZE > vrl;
+        void* ptr = vrl.data();
+        ptr = dlis_unormo( ptr, vr.size() + DLIS_VRL_SIZE );
+        ptr = dlis_ushorto( ptr, 0xFF );
+        ptr = dlis_ushorto( ptr, 1 );
+        file.insert( file.end(), vrl.begin(), vrl.end() );
+        file.insert( file.end(), vr.begin(), vr.end() );
+        vr.clear();
+    };
+
+    for( const auto& rec : recs ) {
+        std::vector< char > payload;
+        if( !rec.isexplicit ) {
+            payload.resize( 6 + rec.name.size() );
+            dlis_obnameo( payload.data(), 1, 0, rec.name.size(),
+                          rec.name.data() );
+        }
+
+        const std::array< char, 4 > pattern = {
+            char( 0x00 ), char( 0x10 ), char( 0xFF ), char( 0x01 )
+        };
+        for( int i = 0; i < rec.bodylen; ++i )
+            payload.push_back( pattern[ i % pattern.size() ] );
+
+        std::size_t written = 0;
+        while( written < payload.size() ) {
+            /*
+             * RP66 segments are at least 16 bytes, so make sure that neither
+             * this segment nor the rest of the record is shorter
+             */
+            const int space = vrmax - DLIS_VRL_SIZE
+                            - int( vr.size() ) - DLIS_LRSH_SIZE;
+            const int left = payload.size() - written;
+            int n = std::min( space, left );
+            if( left - n > 0 && left - n < 12 ) n = left - 12;
+            if( n < 12 ) {
+                flush();
+                continue;
+            }
+
+            std::uint8_t attrs = 0;
+            if( rec.isexplicit )              attrs |= DLIS_SEGATTR_EXFMTLR;
+            if( written > 0 )                 attrs |= DLIS_SEGATTR_PREDSEG;
+            if( written + n < payload.size() ) attrs |= DLIS_SEGATTR_SUCCSEG;
+
+            std::array< char, DLIS_LRSH_SIZE > lrsh;
+            void* ptr = lrsh.data();
+            ptr = dlis_unormo( ptr, n + DLIS_LRSH_SIZE );
+            ptr = dlis_ushorto( ptr, attrs );
+            ptr = dlis_ushorto( ptr, rec.isexplicit ? DLIS_CHANNL : 0 );
+
+            vr.insert( vr.end(), lrsh.begin(), lrsh.end() );
+            vr.insert( vr.end(), payload.begin() + written,
+                                 payload.begin() + written + n );
+            written += n;
+        }
+    }
+
+    if( !vr.empty() ) flush();
+    return file;
+}
+
+/*
+ * Every 8th record is explicit, and the names and bodies are long enough to
+ * be split across segments and visible records of 256 bytes
+ */
+std::vector< logical_record > synthetic_records( int n ) {
+    std::vector< logical_record > recs;
+    for( int i = 0; i < n; ++i ) {
+        const auto name = "CURVE-" + std::string( (i * 7) % 40, 'X' );
+        recs.push_back( { i % 8 == 0, name, 12 + (i * 37) % 300 } );
+    }
+    return recs;
+}
+
+/*
+ * The bookmarks of all records, with the original one-record-at-a-time
+ * tagging, which the other indexers are checked against
+ */
+template< typename File >
+std::vector< dl::bookmark > tag_all( File& fs ) {
+    std::vector< dl::bookmark > marks;
+    int remaining = 0;
+    while( !fs.eof() ) {
+        auto mark = dl::tag( fs, remaining );
+        remaining = mark.first;
+        marks.push_back( mark.second );
+    }
+    return marks;
+}
+
+std::vector< dl::bookmark > marks_of( const dl::record_index& index ) {
+    std::vector< dl::bookmark > marks;
+    for( std::size_t i = 0; i < index.size(); ++i )
+        marks.push_back( index[ i ] );
+    return marks;
+}
+
+void check_marks( const std::vector< dl::bookmark >& marks,
+                  const std::vector< dl::bookmark >& expected ) {
+    REQUIRE( marks.size() == expected.size() );
+    for( std::size_t i = 0; i < marks.size(); ++i ) {
+        INFO( "record " << i );
+        CHECK( marks[ i ].tell        == expected[ i ].tell );
+        CHECK( marks[ i ].residual    == expected[ i ].residual );
+        CHECK( marks[ i ].isexplicit  == expected[ i ].isexplicit );
+        CHECK( marks[ i ].isencrypted == expected[ i ].isencrypted );
+        CHECK( marks[ i ].type        == expected[ i ].type );
+
+        /* the name is only set for implicit records */
+        if( !expected[ i ].isexplicit )
+            CHECK( marks[ i ].name == expected[ i ].name );
+    }
+}
+
+}
+
+TEST_CASE("Parallel index is identical to sequential tagging") {
+    const auto recs = synthetic_records( 200 );
+    const temp_file file( "parallel-index.dlis", write_records( recs, 256 ) );
+
+    dl::mapped_file fs( file.path );
+    const auto expected = tag_all( fs );
+    REQUIRE( expected.size() == recs.size() );
+
+    for( int threads : { 1, 2, 3, 4, 7, 16 } ) {
+        INFO( "threads = " << threads );
+        dl::index_report report;
+        check_marks( dl::parallel_index( fs, 0, threads, &report ), expected );
+        CHECK( fs.eof() );
+        CHECK( report.ranges == threads );
+        CHECK( report.fallbacks > 0 );
+    }
+}
+
+TEST_CASE("Index round-trips through sidecar file") {
+    std::vector< logical_record > recs;
+    for( int i = 0; i < 50; ++i ) {
+        const bool isexplicit = i % 7 == 0;
+        const auto name = "CURVE-" + std::to_string( i % 3 );
+        recs.push_back( { isexplicit, name, 12 + (i * 37) % 300 } );
+    }
+
+    const temp_file file( "sidecar.dlis", write_records( recs, 256 ) );
+    const temp_file idx( "sidecar.dlis.idx" );
+
+    dl::mapped_file fs( file.path );
+    dl::vrl_table vrls;
+    auto index = dl::make_index( dl::parallel_index( fs, 0, 1, nullptr, &vrls ) );
+    index.vrls = vrls;
+    fs.close();
+
+    CHECK( index.explicits.size() == 8 );
+    CHECK( index.implicits.size() == 3 );
+
+    dl::file_index loaded;
+    CHECK( !dl::read_index( idx.path, file.path, loaded ) );
+
+    dl::write_index( idx.path, file.path, index );
+    REQUIRE( dl::read_index( idx.path, file.path, loaded ) );
+
+    check_marks( marks_of( loaded.records ), marks_of( index.records ) );
+    CHECK( loaded.records.names.size() == 3 );
+
+    CHECK( loaded.explicits == index.explicits );
+    CHECK( loaded.implicits == index.implicits );
+    CHECK( loaded.vrls.offsets == index.vrls.offsets );
+    CHECK( loaded.vrls.lengths == index.vrls.lengths );
+    CHECK( loaded.vrls.starts  == index.vrls.starts );
+
+    SECTION("a stale index is rejected") {
+        {
+            std::ofstream out( file.path, std::ios_base::binary
+                                        | std::ios_base::app );
+            out.put( 0 );
+        }
+        dl::file_index stale;
+        CHECK( !dl::read_index( idx.path, file.path, stale ) );
+        CHECK( stale.records.size() == 0 );
+    }
+
+#ifndef _WIN32
+    SECTION("a rewrite in the same second is rejected") {
+        struct stat st;
+        REQUIRE( ::stat( file.path.c_str(), &st ) == 0 );
+
+        /* same size and second, but a different nanosecond */
+        struct timespec times[ 2 ];
+        times[ 0 ].tv_sec  = st.st_mtime;
+        times[ 0 ].tv_nsec = 100;
+        times[ 1 ] = times[ 0 ];
+        REQUIRE( ::utimensat( AT_FDCWD, file.path.c_str(), times, 0 ) == 0 );
+        dl::write_index( idx.path, file.path, index );
+        REQUIRE( dl::read_index( idx.path, file.path, loaded ) );
+
+        times[ 1 ].tv_nsec = 200;
+        REQUIRE( ::utimensat( AT_FDCWD, file.path.c_str(), times, 0 ) == 0 );
+        dl::file_index stale;
+        CHECK( !dl::read_index( idx.path, file.path, stale ) );
+    }
+#endif
+
+    SECTION("an existing index is replaced") {
+        std::vector< char > bytes;
+        {
+            std::ifstream in( idx.path, std::ios_base::binary );
+            bytes.assign( std::istreambuf_iterator< char >( in ),
+                          std::istreambuf_iterator< char >() );
+        }
+        idx.write( bytes, bytes.size() - 3 );
+        dl::write_index( idx.path, file.path, index );
+
+        dl::file_index replaced;
+        REQUIRE( dl::read_index( idx.path, file.path, replaced ) );
+        check_marks( marks_of( replaced.records ), marks_of( index.records ) );
+    }
+
+    SECTION("an unwritable index throws") {
+        const auto path = file.path + ".no-such-dir/idx";
+        CHECK_THROWS_AS( dl::write_index( path, file.path, index ),
+                         std::runtime_error );
+    }
+
+    SECTION("a truncated index is rejected") {
+        std::vector< char > bytes;
+        {
+            std::ifstream in( idx.path, std::ios_base::binary );
+            bytes.assign( std::istreambuf_iterator< char >( in ),
+                          std::istreambuf_iterator< char >() );
+        }
+        idx.write( bytes, bytes.size() - 3 );
+        dl::file_index truncated;
+        CHECK( !dl::read_index( idx.path, file.path, truncated ) );
+    }
+}
+
+TEST_CASE("Buffered file tags like memory-mapped file") {
+    const auto bytes = write_records( synthetic_records( 100 ), 256 );
+
+    std::vector< dl::bookmark > expected;
+    {
+        const temp_file file( "buffered.dlis", bytes );
+        dl::mapped_file mapped( file.path );
+        expected = tag_all( mapped );
+    }
+
+    using file = dl::buffered_file< std::stringstream >;
+    for( std::size_t window : { 1, 7, 64, 4096, 1 << 16 } )
+    for( std::size_t readahead : { 0, 1 << 16 } ) {
+        INFO( "window = " << window << ", readahead = " << readahead );
+
+        std::stringstream ss;
+        ss.write( bytes.data(), bytes.size() );
+        file fs( std::move( ss ), window, readahead );
+
+        const auto marks = tag_all( fs );
+        check_marks( marks, expected );
+
+        if( window >= 4096 )
+            CHECK( fs.refills() < marks.size() );
+
+        fs.seek( 0 );
+        CHECK( fs.read( bytes.size() ) == bytes );
+        CHECK_THROWS_AS( fs.read< 1 >(), std::out_of_range );
+    }
+}
+
+TEST_CASE("Record batch matches record views in position order") {
+    const auto bytes = write_records( synthetic_records( 60 ), 256 );
+    const temp_file file( "batch.dlis", bytes );
+
+    dl::mapped_file fs( file.path );
+    const auto index = dl::make_index( dl::parallel_index( fs, 0, 1 ) );
+    const auto& records = index.records;
+    REQUIRE( records.size() == 60 );
+
+    /* every other record, back to front */
+    std::vector< std::size_t > positions;
+    for( std::size_t i = records.size(); i > 0; i -= 2 )
+        positions.push_back( i - 1 );
+
+    dl::record_batch batch( fs, records, positions );
+    REQUIRE( batch.size() == positions.size() );
+
+    dl::record_view view;
+    std::vector< char > lhs, rhs;
+    for( std::size_t i = 0; i < positions.size(); ++i ) {
+        const auto mark = records[ positions[ i ] ];
+        CHECK( batch.mark( i ).tell == mark.tell );
+
+        fs.seek( mark.tell );
+        dl::view_record( fs, mark.residual, view );
+
+        const auto* expected = view.data( lhs );
+        const auto* actual = batch[ i ].data( rhs );
+        REQUIRE( batch[ i ].size() == view.size() );
+        CHECK( std::equal( expected, expected + view.size(), actual ) );
+    }
+
+    /* with a large gap, everything is merged into a single range */
+    CHECK( batch.ranges().size() == 1 );
+    CHECK( batch.ranges().front().begin == records.tells[ positions.back() ] );
+    CHECK( batch.ranges().front().end == fs.size() );
+
+    /* without, every record is its own range, ending at the next record */
+    const dl::record_batch exact( fs, records, positions, 0 );
+    REQUIRE( exact.ranges().size() == positions.size() );
+    for( std::size_t i = 0; i + 1 < positions.size(); ++i ) {
+        const auto& range = exact.ranges()[ i ];
+        const auto pos = positions[ positions.size() - 1 - i ];
+        CHECK( range.begin == records.tells[ pos ] );
+        CHECK( range.end == records.tells[ pos + 1 ] );
+    }
+
+    SECTION("records past the end of the file fail one by one") {
+        const temp_file cutfile( "batch-truncated.dlis" );
+        cutfile.write( bytes, bytes.size() - 5 );
+
+        dl::mapped_file cut( cutfile.path );
+        dl::record_batch truncated( cut, records, positions );
+
+        /* the last record in the file is the first one requested */
+        CHECK_THROWS_AS( truncated[ 0 ], std::out_of_range );
+        CHECK_THROWS_AS( truncated[ 0 ], std::out_of_range );
+        for( std::size_t i = 1; i < positions.size(); ++i )
+            CHECK( truncated[ i ].size() == batch[ i ].size() );
+    }
+}
+
+TEST_CASE("Coalesce merges overlapping and nearby ranges") {
+    std::vector< dl::byte_range > ranges( 4 );
+    ranges[ 0 ].begin = 100; ranges[ 0 ].end = 110;
+    ranges[ 1 ].begin =   0; ranges[ 1 ].end =  10;
+    ranges[ 2 ].begin =   5; ranges[ 2 ].end =  20;
+    ranges[ 3 ].begin =  24; ranges[ 3 ].end =  30;
+
+    const auto tight = dl::coalesce( ranges, 0 );
+    REQUIRE( tight.size() == 3 );
+    CHECK( tight[ 0 ].begin == 0 );
+    CHECK( tight[ 0 ].end   == 20 );
+
+    const auto loose = dl::coalesce( ranges, 4 );
+    REQUIRE( loose.size() == 2 );
+    CHECK( loose[ 0 ].end   == 30 );
+    CHECK( loose[ 1 ].begin == 100 );
+}
+
+TEST_CASE("Record index interns names and re-creates bookmarks") {
+    std::vector< logical_record > recs;
+    for( int i = 0; i < 40; ++i ) {
+        const auto name = "CURVE-" + std::to_string( i % 4 );
+        recs.push_back( { i % 10 == 0, name, 12 + (i * 29) % 200 } );
+    }
+
+    const temp_file file( "record-index.dlis", write_records( recs, 256 ) );
+    dl::mapped_file fs( file.path );
+    const auto marks = dl::parallel_index( fs, 0, 1 );
+
+    dl::record_index index;
+    for( const auto& mark : marks )
+        index.push_back( mark );
+
+    CHECK( index.names.size() == 4 );
+    check_marks( marks_of( index ), marks );
+
+    for( std::size_t i = 0; i < marks.size(); ++i ) {
+        if( marks[ i ].isexplicit ) {
+            CHECK( index.nameids[ i ] == -1 );
+            CHECK( index.flags[ i ] == dl::record_index::explicit_record );
+        } else {
+            CHECK( index.names[ index.nameids[ i ] ] == marks[ i ].name );
+        }
+    }
+
+    CHECK_THROWS_AS( index[ marks.size() ], std::out_of_range );
+}
+
+TEST_CASE("Scanning reports truncation and end-of-file as status codes") {
+    const auto bytes = write_records( synthetic_records( 30 ), 256 );
+    const temp_file file( "scan.dlis", bytes );
+
+    dl::mapped_file fs( file.path );
+    const auto expected = tag_all( fs );
+
+    dl::scan_state state;
+    dl::bookmark mark;
+    std::vector< dl::bookmark > scanned;
+    while( dl::scan_record( fs, state, mark ) == DLIS_OK )
+        scanned.push_back( mark );
+
+    check_marks( scanned, expected );
+    CHECK( state.pos == std::streamsize( bytes.size() ) );
+    CHECK( dl::scan_record( fs, state, mark ) == DLIS_EOF );
+    fs.close();
+
+    SECTION("truncated files stop at the last complete record") {
+        for( std::size_t cut = 1; cut < bytes.size(); cut += 97 ) {
+            INFO( "file truncated to " << cut << " bytes" );
+            file.write( bytes, cut );
+            dl::mapped_file truncated( file.path );
+
+            dl::scan_state st;
+            std::size_t records = 0;
+            int err;
+            while( (err = dl::scan_record( truncated, st, mark )) == DLIS_OK )
+                ++records;
+
+            CHECK( (err == DLIS_TRUNCATED || err == DLIS_EOF) );
+            CHECK( records <= expected.size() );
+            if( records < expected.size() ) {
+                CHECK( err == DLIS_TRUNCATED );
+                CHECK( st.pos == expected[ records ].tell );
+            }
+        }
+    }
+
+    SECTION("inconsistent segment lengths are reported") {
+        auto broken = bytes;
+        /* make the first segment longer than its visible record */
+        broken[ DLIS_VRL_SIZE ] = char( 0x7F );
+        file.write( broken );
+
+        dl::mapped_file bad( file.path );
+        dl::scan_state st;
+        CHECK( dl::scan_record( bad, st, mark ) == DLIS_INCONSISTENT );
+        CHECK( st.pos == 0 );
+    }
+}
+
+TEST_CASE("Parallel index drops the incomplete record of a truncated file") {
+    const auto bytes = write_records( synthetic_records( 40 ), 256 );
+    const temp_file file( "truncated-index.dlis" );
+
+    /* cut at every few bytes, which hits labels, headers and bodies */
+    for( std::size_t cut = 1; cut <= bytes.size(); cut += 13 ) {
+        INFO( "file truncated to " << cut << " bytes" );
+        file.write( bytes, cut );
+        dl::mapped_file fs( file.path );
+
+        std::vector< dl::bookmark > expected;
+        dl::vrl_table expected_vrls;
+        dl::scan_state state;
+        dl::bookmark mark;
+        int err;
+        while( (err = dl::scan_record( fs, state, mark, &expected_vrls ))
+                == DLIS_OK )
+            expected.push_back( mark );
+
+        const std::int64_t truncated = err == DLIS_TRUNCATED ? state.pos : -1;
+
+        for( int threads : { 1, 3 } ) {
+            INFO( "threads = " << threads );
+            dl::index_report report;
+            dl::vrl_table vrls;
+            const auto marks = dl::parallel_index( fs, 0, threads,
+                                                   &report, &vrls );
+
+            CHECK( report.truncated == truncated );
+            CHECK( fs.tell() == state.pos );
+            CHECK( vrls.offsets == expected_vrls.offsets );
+            check_marks( marks, expected );
+        }
+    }
+}
+
+TEST_CASE("Scanning resumes after damage with resync") {
+    /*
+     * the record bodies are filled with 00 10 FF 01, which look like visible
+     * record labels, so resync must reject a lot of false candidates
+     */
+    auto bytes = write_records( synthetic_records( 80 ), 256 );
+    const temp_file file( "resync.dlis", bytes );
+
+    std::vector< dl::bookmark > expected;
+    dl::scan_state state;
+    dl::bookmark mark;
+    {
+        dl::mapped_file fs( file.path );
+        while( dl::scan_record( fs, state, mark ) == DLIS_OK )
+            expected.push_back( mark );
+    }
+    REQUIRE( expected.size() == 80 );
+
+    /* wipe out a chunk in the middle of the file */
+    const std::size_t damage = bytes.size() / 3;
+    std::fill( bytes.begin() + damage, bytes.begin() + damage + 300, 0 );
+    file.write( bytes );
+
+    dl::mapped_file damaged( file.path );
+    std::vector< dl::bookmark > marks;
+    int resyncs = 0;
+    state = dl::scan_state();
+    while( true ) {
+        const auto err = dl::scan_record( damaged, state, mark );
+        if( err == DLIS_OK ) {
+            marks.push_back( mark );
+            continue;
+        }
+
+        if( err == DLIS_EOF ) break;
+        ++resyncs;
+        REQUIRE( resyncs < 10 );
+        if( !dl::resync( damaged, state ) ) break;
+    }
+
+    CHECK( resyncs >= 1 );
+
+    /* every record found is a real record */
+    std::size_t matched = 0;
+    for( const auto& m : marks ) {
+        const auto itr = std::find_if( expected.begin(), expected.end(),
+            [&]( const dl::bookmark& x ) { return x.tell == m.tell; }
+        );
+        REQUIRE( itr != expected.end() );
+        CHECK( m.residual == itr->residual );
+
+        /* the name could be in the damaged bytes */
+        const bool intact = m.tell >= std::streamsize( damage + 300 );
+        if( intact && !itr->isexplicit ) CHECK( m.name == itr->name );
+        ++matched;
+    }
+
+    /* and only the records near the damage are lost */
+    const auto after = std::count_if( expected.begin(), expected.end(),
+        [&]( const dl::bookmark& x ) {
+            return x.tell >= std::streamsize( damage + 300 + 256 );
+        }
+    );
+    CHECK( after > 0 );
+    CHECK( std::count_if( marks.begin(), marks.end(),
+        [&]( const dl::bookmark& x ) {
+            return x.tell >= std::streamsize( damage + 300 + 256 );
+        }
+    ) == after );
+    CHECK( matched + 10 > expected.size() );
+}
+
+TEST_CASE("Visible record table maps logical to physical offsets") {
+    const auto bytes = write_records( synthetic_records( 50 ), 256 );
+    const temp_file file( "vrl-table.dlis", bytes );
+    dl::mapped_file fs( file.path );
+
+    dl::vrl_table parallel;
+    const auto marks = dl::parallel_index( fs, 0, 3, nullptr, &parallel );
+
+    dl::vrl_table sequential;
+    dl::scan_state state;
+    dl::bookmark mark;
+    while( dl::scan_record( fs, state, mark, &sequential ) == DLIS_OK ) {}
+
+    CHECK( parallel.offsets == sequential.offsets );
+    CHECK( parallel.lengths == sequential.lengths );
+    REQUIRE( parallel.size() > 1 );
+
+    const auto& vrls = parallel;
+    std::int64_t logical = 0;
+    for( std::size_t i = 0; i < vrls.size(); ++i ) {
+        const auto body = vrls.offsets[ i ] + DLIS_VRL_SIZE;
+        const auto bodylen = vrls.lengths[ i ] - DLIS_VRL_SIZE;
+
+        CHECK( vrls.starts[ i ] == logical );
+        CHECK( vrls.physical( logical ) == body );
+        CHECK( vrls.physical( logical + bodylen - 1 ) == body + bodylen - 1 );
+        CHECK( vrls.logical( body + 7 ) == logical + 7 );
+        CHECK( vrls.find( vrls.offsets[ i ] ) == i );
+        CHECK_THROWS_AS( vrls.logical( vrls.offsets[ i ] ), std::out_of_range );
+
+        logical += bodylen;
+    }
+
+    CHECK_THROWS_AS( vrls.physical( logical ), std::out_of_range );
+    CHECK_THROWS_AS( vrls.physical( -1 ), std::out_of_range );
+    CHECK_THROWS_AS( vrls.find( std::int64_t( bytes.size() ) ),
+                     std::out_of_range );
+
+    /* the residual of a bookmark is just the rest of its visible record */
+    for( const auto& m : marks ) {
+        if( m.residual == 0 ) continue;
+        CHECK( vrls.remaining( m.tell ) == m.residual );
+    }
+}
+
+TEST_CASE( "frame plan offsets", "[frame]" ) {
+    /* fsingl[2], fdoubl, ident, unorm[3], ascii, slong */
+    const std::vector< int > reprcs = {
+        DLIS_FSINGL, DLIS_FDOUBL, DLIS_IDENT, DLIS_UNORM, DLIS_ASCII, DLIS_SLONG
+    };
+    const std::vector< int > counts = { 2, 1, 1, 3, 1, 1 };
+    const dl::frame_plan plan( reprcs, counts );
+
+    REQUIRE( plan.size() == 6 );
+    CHECK(  plan.fixed( 0 ) );
+    CHECK(  plan.fixed( 1 ) );
+    CHECK( !plan.fixed( 2 ) );
+    CHECK( !plan.fixed( 3 ) );
+    CHECK( !plan.fixed( 5 ) );
+    CHECK( plan.width( 0 ) == 8 );
+    CHECK( plan.width( 3 ) == 6 );
+    CHECK( plan.width( 4 ) == 0 );
+
+    /* offsets up to the first variable-size channel don't need the frame */
+    CHECK( plan.offset( 0, nullptr, nullptr ) == 0 );
+    CHECK( plan.offset( 1, nullptr, nullptr ) == 8 );
+    CHECK( plan.offset( 2, nullptr, nullptr ) == 16 );
+
+    const unsigned char frame[] = {
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0x03, 'D', 'E', 'P',
+        0, 1, 0, 2, 0, 3,
+        0x02, 'A', 'B',
+        0, 0, 0, 1,
+    };
+    const auto* body = reinterpret_cast< const char* >( frame );
+    const auto* end = body + sizeof( frame );
+    CHECK( plan.offset( 3, body, end ) == 20 );
+    CHECK( plan.offset( 4, body, end ) == 26 );
+    CHECK( plan.offset( 5, body, end ) == 29 );
+
+    CHECK_THROWS_AS( plan.offset( 6, body, end ), std::out_of_range );
+
+    /* a short or malformed body never reads past end */
+    CHECK( plan.offset( 5, body, body + 29 ) == 29 );
+    CHECK_THROWS_AS( plan.offset( 5, body, body + 28 ), std::out_of_range );
+    CHECK_THROWS_AS( plan.offset( 3, body, body + 17 ), std::out_of_range );
+    CHECK_THROWS_AS( plan.offset( 3, body, body + 8 ), std::out_of_range );
+    CHECK_THROWS_AS( dl::frame_plan( { 0 }, { 1 } ), std::invalid_argument );
+    CHECK_THROWS_AS( dl::frame_plan( { DLIS_FSINGL }, { -1 } ),
+                     std::invalid_argument );
+    CHECK_THROWS_AS( dl::frame_plan( { DLIS_FSINGL }, { 1, 2 } ),
+                     std::invalid_argument );
+}
@@ -0,0 +1,638 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <dlisio/dlisio.h>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/types.hpp>
+
+#include "tempfile.hpp"
+
+namespace {
+
+/*
+ * The example channel set from the specification, figure 3-8, without the
+ * segment headers and trailers
+ */
+const std::vector< unsigned char > stdrecord = {
+    0xF8,
+    0x07, 0x43, 0x48, 0x41, 0x4E, 0x4E, 0x45, 0x4C,
+    0x01, 0x30,
+
+    0x34,
+    0x09, 0x4C, 0x4F, 0x4E, 0x47, 0x2D, 0x4E, 0x41, 0x4D, 0x45,
+    0x17,
+
+    0x35,
+    0x0D, 0x45, 0x4C, 0x45, 0x4D, 0x45, 0x4E, 0x54, 0x2D, 0x4C,
+    0x49, 0x4D, 0x49, 0x54,
+    0x12,
+    0x01,
+
+    0x35,
+    0x13, 0x52, 0x45, 0x50, 0x52, 0x45, 0x53, 0x45, 0x4E, 0x54,
+    0x41, 0x54, 0x49, 0x4F, 0x4E, 0x2D, 0x43, 0x4F, 0x44, 0x45,
+    0x0F,
+    0x02,
+
+    0x30,
+    0x05, 0x55, 0x4E, 0x49, 0x54, 0x53,
+
+    0x35,
+    0x09, 0x44, 0x49, 0x4D, 0x45, 0x4E, 0x53, 0x49, 0x4F, 0x4E,
+    0x12,
+    0x01,
+
+    0x70,
+    0x00, 0x00, 0x04, 0x54, 0x49, 0x4D, 0x45,
+    0x21, 0x00, 0x00, 0x01, 0x31,
+    0x20,
+    0x20,
+    0x21,
+    0x01, 0x73,
+
+    0x70,
+    0x01, 0x00, 0x08, 0x50, 0x52, 0x45, 0x53, 0x53, 0x55, 0x52, 0x45,
+    0x21,
+    0x00, 0x00, 0x01, 0x32,
+    0x20,
+    0x21, 0x07,
+    0x21,
+    0x03, 0x70, 0x73, 0x69,
+
+    0x70,
+    0x00, 0x01, 0x09, 0x50, 0x41, 0x44, 0x2D, 0x41, 0x52, 0x52, 0x41, 0x59,
+    0x21,
+    0x00, 0x00, 0x01, 0x33,
+    0x29,
+    0x02,
+    0x08, 0x14,
+    0x21,
+    0x0D,
+    0x00,
+    0x29,
+    0x02,
+    0x08, 0x0A,
+};
+
+/*
+ * A FRAME set of two frames, one made from the channels of stdrecord, and
+ * one with a channel that does not exist
+ */
+const std::vector< unsigned char > framerecord = {
+    0xF8,
+    0x05, 0x46, 0x52, 0x41, 0x4D, 0x45, /* "FRAME" */
+    0x01, 0x30,
+
+    0x34,
+    0x08, 0x43, 0x48, 0x41, 0x4E, 0x4E, 0x45, 0x4C, 0x53, /* "CHANNELS" */
+    0x17,
+
+    0x34,
+    0x0A, 0x49, 0x4E, 0x44, 0x45, 0x58, 0x2D, 0x54, 0x59, 0x50, 0x45,
+    0x13,
+
+    0x30,
+    0x07, 0x53, 0x50, 0x41, 0x43, 0x49, 0x4E, 0x47, /* "SPACING" */
+
+    0x70,
+    0x00, 0x00, 0x02, 0x46, 0x31, /* (0, 0, "F1") */
+    0x29,
+    0x02,
+    0x00, 0x00, 0x04, 0x54, 0x49, 0x4D, 0x45,
+    0x01, 0x00, 0x08, 0x50, 0x52, 0x45, 0x53, 0x53, 0x55, 0x52, 0x45,
+    0x21,
+    0x04, 0x54, 0x49, 0x4D, 0x45, /* "TIME" */
+    0x25,
+    0x07,
+    0x3F, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0.5 */
+
+    0x70,
+    0x00, 0x00, 0x02, 0x46, 0x32, /* (0, 0, "F2") */
+    0x21,
+    0x00, 0x00, 0x04, 0x4E, 0x4F, 0x50, 0x45, /* (0, 0, "NOPE") */
+};
+
+const char* begin_of( const std::vector< unsigned char >& xs ) {
+    return reinterpret_cast< const char* >( xs.data() );
+}
+
+const char* end_of( const std::vector< unsigned char >& xs ) {
+    return begin_of( xs ) + xs.size();
+}
+
+/*
+ * Write every record in its own visible record. Records longer than split
+ * bytes are split into two segments.
+ */
+void write_eflrs( const std::string& path,
+                  const std::vector< std::vector< unsigned char > >& bodies,
+                  const std::vector< std::uint8_t >& types,
+                  const std::vector< std::uint8_t >& attrs,
+                  std::size_t split ) {
+    std::ofstream out( path, std::ios_base::binary );
+
+    for (std::size_t i = 0; i < bodies.size(); ++i) {
+        const auto& body = bodies[ i ];
+        const auto segments = body.size() > split ? 2 : 1;
+        const auto len = body.size() + segments * DLIS_LRSH_SIZE;
+
+        char vrl[ DLIS_VRL_SIZE ];
+        void* ptr = vrl;
+        ptr = dlis_unormo( ptr, len + DLIS_VRL_SIZE );
+        ptr = dlis_ushorto( ptr, 0xFF );
+        ptr = dlis_ushorto( ptr, 1 );
+        out.write( vrl, sizeof( vrl ) );
+
+        std::size_t written = 0;
+        for (int seg = 0; seg < segments; ++seg) {
+            const auto n = seg == segments - 1 ? body.size() - written
+                                               : split;
+
+            std::uint8_t flags = DLIS_SEGATTR_EXFMTLR | attrs[ i ];
+            if (seg > 0)            flags |= DLIS_SEGATTR_PREDSEG;
+            if (seg < segments - 1) flags |= DLIS_SEGATTR_SUCCSEG;
+
+            char lrsh[ DLIS_LRSH_SIZE ];
+            ptr = lrsh;
+            ptr = dlis_unormo( ptr, n + DLIS_LRSH_SIZE );
+            ptr = dlis_ushorto( ptr, flags );
+            ptr = dlis_ushorto( ptr, types[ i ] );
+            out.write( lrsh, sizeof( lrsh ) );
+
+            out.write( begin_of( body ) + written, n );
+            written += n;
+        }
+    }
+}
+
+}
+
+TEST_CASE("EFLR of channels is parsed into typed objects") {
+    const auto set = dl::parse_eflr( begin_of( stdrecord ),
+                                     end_of( stdrecord ),
+                                     DLIS_CHANNL );
+
+    CHECK( dl::decay( set.type ) == "CHANNEL" );
+    CHECK( dl::decay( set.name ) == "0" );
+    REQUIRE( set.tmpl.size() == 5 );
+
+    const auto& elimit = set.tmpl[1].value;
+    CHECK( elimit.get< dl::uvari >() == std::vector< dl::uvari >{
+        dl::uvari{ 1 }
+    } );
+
+    const auto& channels = boost::get< std::vector< dl::channel > >(
+        set.objects
+    );
+    REQUIRE( channels.size() == 3 );
+
+    CHECK( channels[0].get_name() == "TIME" );
+    CHECK( channels[1].reprc == dl::representation_code::fdoubl );
+    CHECK( dl::decay( channels[1].units ) == "psi" );
+
+    const auto& pad = channels[2];
+    CHECK( pad.reprc == dl::representation_code::snorm );
+    CHECK( pad.element_limit == std::vector< dl::uvari >{ dl::uvari{ 8 },
+                                                          dl::uvari{ 20 } } );
+    CHECK( pad.dimension == std::vector< dl::uvari >{ dl::uvari{ 8 },
+                                                      dl::uvari{ 10 } } );
+}
+
+TEST_CASE("Unknown objects keep their attributes in the record copy") {
+    auto buffer = stdrecord;
+    auto set = dl::parse_eflr( begin_of( buffer ),
+                               end_of( buffer ),
+                               DLIS_UDI + 100 );
+
+    /* the set has its own copy, so the input can go away */
+    std::fill( buffer.begin(), buffer.end(), 0 );
+    buffer.clear();
+    buffer.shrink_to_fit();
+
+    const auto& objects = boost::get< std::vector< dl::unknown_object > >(
+        set.objects
+    );
+    REQUIRE( objects.size() == 3 );
+
+    const auto& pressure = objects[1];
+    CHECK( pressure.get_name() == "PRESSURE" );
+
+    const auto& attrs = pressure.attributes;
+    REQUIRE( attrs.size() == 5 );
+    CHECK( dl::decay( attrs[4].label ) == "DIMENSION" );
+
+    CHECK( dl::decay( attrs[3].label ) == "UNITS" );
+    const auto units = attrs[3].value.get< dl::ident >();
+    REQUIRE( units.size() == 1 );
+    CHECK( dl::decay( units.front() ) == "psi" );
+
+    const auto* record = set.record.get();
+    CHECK( attrs[3].value.data() > record );
+    CHECK( attrs[3].value.data() < record + stdrecord.size() );
+}
+
+TEST_CASE("Attribute values are decoded on typed access") {
+    auto buffer = stdrecord;
+    const auto set = dl::parse_eflr( begin_of( buffer ),
+                                     end_of( buffer ),
+                                     DLIS_UDI + 100 );
+
+    /* the set has its own copy of the record */
+    std::fill( buffer.begin(), buffer.end(), 0xFF );
+    buffer.clear();
+    buffer.shrink_to_fit();
+
+    const auto& objects = boost::get< std::vector< dl::unknown_object > >(
+        set.objects
+    );
+    REQUIRE( objects.size() == 3 );
+
+    const auto& attrs = objects[2].attributes;
+    REQUIRE( attrs.size() == 5 );
+
+    const auto& elimit = attrs[1].value;
+    CHECK( elimit.reprc() == dl::representation_code::uvari );
+    CHECK( elimit.size() == 2 );
+    CHECK( elimit.bytes() == 2 );
+    CHECK( elimit.get< dl::uvari >() == std::vector< dl::uvari >{
+        dl::uvari{ 8 },
+        dl::uvari{ 20 },
+    } );
+
+    CHECK_THROWS_AS( elimit.get< dl::ident >(), std::invalid_argument );
+
+    const auto& name = attrs[0].value;
+    const auto obnames = name.get< dl::obname >();
+    REQUIRE( obnames.size() == 1 );
+    CHECK( obnames.front() == dl::obname{ dl::origin{ 0 },
+                                          dl::ushort{ 0 },
+                                          dl::ident{ "3" } } );
+
+    /* absent attributes have no value */
+    CHECK( dl::decay( attrs[3].label ) == "UNITS" );
+    CHECK( attrs[3].value.empty() );
+    CHECK( attrs[3].value.get< dl::fshort >().empty() );
+}
+
+TEST_CASE("Attribute values past end-of-record are rejected") {
+    /* PAD-ARRAY's DIMENSION count is 2, but only one value is present */
+    const auto truncated = std::vector< unsigned char >(
+        stdrecord.begin(),
+        stdrecord.end() - 1
+    );
+
+    CHECK_THROWS_AS( dl::parse_eflr( begin_of( truncated ),
+                                     end_of( truncated ),
+                                     DLIS_UDI + 100 ),
+                     std::out_of_range );
+}
+
+TEST_CASE("Objects refer to the template for attributes they don't override") {
+    const auto set = dl::parse_eflr( begin_of( stdrecord ),
+                                     end_of( stdrecord ),
+                                     DLIS_UDI + 100 );
+
+    const auto& objects = boost::get< std::vector< dl::unknown_object > >(
+        set.objects
+    );
+    REQUIRE( objects.size() == 3 );
+
+    /* TIME overrides LONG-NAME and UNITS, and nothing else */
+    const auto& time = objects[0].attributes;
+    REQUIRE( time.size() == set.tmpl.size() );
+
+    for (auto i : { 1, 2, 4 }) {
+        CHECK( time[i].label == set.tmpl[i].label );
+        CHECK( time[i].value.data() == set.tmpl[i].value.data() );
+    }
+
+    CHECK( time[0].value.data() != set.tmpl[0].value.data() );
+    CHECK( time[3].value.get< dl::ident >() == std::vector< dl::ident >{
+        dl::ident{ "s" }
+    } );
+
+    const auto chset = dl::parse_eflr( begin_of( stdrecord ),
+                                       end_of( stdrecord ),
+                                       DLIS_CHANNL );
+    const auto& ch = boost::get< std::vector< dl::channel > >(
+        chset.objects
+    );
+    CHECK( ch[0].reprc == dl::representation_code::fsingl );
+    CHECK( ch[0].element_limit == std::vector< dl::uvari >{ dl::uvari{ 1 } } );
+    CHECK( ch[1].element_limit == std::vector< dl::uvari >{ dl::uvari{ 1 } } );
+}
+
+TEST_CASE("Channel attributes are dispatched on label") {
+    const unsigned char props[] = {
+        0x05, 0x4C, 0x4F, 0x43, 0x41, 0x4C, /* "LOCAL" */
+        0x03, 0x52, 0x41, 0x57,             /* "RAW" */
+    };
+    const auto* xs = reinterpret_cast< const char* >( props );
+
+    dl::object_attribute attr;
+    attr.label = dl::ident{ "PROPERTIES" };
+    attr.reprc = dl::representation_code::ident;
+    attr.count = dl::uvari{ 2 };
+    attr.value = dl::value_vector( attr.reprc, 2, xs, xs + sizeof( props ) );
+
+    dl::channel ch;
+    ch.set( attr );
+    CHECK( ch.properties == std::vector< dl::ident >{ dl::ident{ "LOCAL" },
+                                                      dl::ident{ "RAW" } } );
+
+    /* same length and nearly the same bytes, but not a channel label */
+    attr.label = dl::ident{ "PROPERTIEZ" };
+    CHECK_THROWS_AS( ch.set( attr ), std::invalid_argument );
+
+    attr.label = dl::ident{ "" };
+    CHECK_THROWS_AS( ch.set( attr ), std::invalid_argument );
+
+    /* the file header has a different set of labels */
+    dl::file_header fh;
+    attr.label = dl::ident{ "PROPERTIES" };
+    CHECK_THROWS_AS( fh.set( attr ), std::invalid_argument );
+}
+
+TEST_CASE("Unknown objects update attributes in any order") {
+    const unsigned char one[] = { 0x01 };
+    const unsigned char two[] = { 0x02 };
+    const auto* x1 = reinterpret_cast< const char* >( one );
+    const auto* x2 = reinterpret_cast< const char* >( two );
+    const auto rep = dl::representation_code::ushort;
+
+    dl::unknown_object obj;
+    for (const auto* label : { "A", "B", "C" }) {
+        dl::object_attribute attr;
+        attr.label = dl::ident{ label };
+        attr.reprc = rep;
+        attr.value = dl::value_vector( rep, 1, x1, x1 + 1 );
+        obj.set( attr );
+    }
+
+    for (const auto* label : { "B", "A", "C", "C" }) {
+        dl::object_attribute attr;
+        attr.label = dl::ident{ label };
+        attr.reprc = rep;
+        attr.value = dl::value_vector( rep, 1, x2, x2 + 1 );
+        obj.set( attr );
+    }
+
+    REQUIRE( obj.attributes.size() == 3 );
+    CHECK( dl::decay( obj.attributes[0].label ) == "A" );
+    CHECK( dl::decay( obj.attributes[1].label ) == "B" );
+    CHECK( dl::decay( obj.attributes[2].label ) == "C" );
+    for (const auto& attr : obj.attributes)
+        CHECK( attr.value.get< dl::ushort >() == std::vector< dl::ushort >{ 2 } );
+}
+
+TEST_CASE("Frames are resolved to their channels") {
+    std::vector< dl::object_set > sets;
+    sets.push_back( dl::parse_eflr( begin_of( stdrecord ),
+                                    end_of( stdrecord ),
+                                    DLIS_CHANNL ) );
+    sets.push_back( dl::parse_eflr( begin_of( framerecord ),
+                                    end_of( framerecord ),
+                                    DLIS_FRAME ) );
+
+    const auto& frames = boost::get< std::vector< dl::frame > >(
+        sets.back().objects
+    );
+    REQUIRE( frames.size() == 2 );
+
+    const auto& f1 = frames[0];
+    CHECK( f1.get_name() == "F1" );
+    CHECK( dl::decay( f1.index_type ) == "TIME" );
+    CHECK( f1.spacing.get< dl::fdoubl >() == std::vector< dl::fdoubl >{ 0.5 } );
+    REQUIRE( f1.channels.size() == 2 );
+
+    /* F2 does not override anything but CHANNELS */
+    const auto& f2 = frames[1];
+    CHECK( dl::decay( f2.index_type ).empty() );
+    CHECK( f2.spacing.empty() );
+
+    const dl::channel_index index( sets );
+    CHECK( index.size() == 3 );
+
+    const auto channels = index.resolve( f1 );
+    REQUIRE( channels.size() == 2 );
+    CHECK( channels[0]->get_name() == "TIME" );
+    CHECK( channels[1]->get_name() == "PRESSURE" );
+    CHECK( &index.at( f1.channels[1] ) == channels[1] );
+
+    CHECK_THROWS_AS( index.resolve( f2 ), std::out_of_range );
+
+    const auto plan = dl::make_frame_plan( channels );
+    REQUIRE( plan.size() == 2 );
+    CHECK( plan.reprc( 0 ) == DLIS_FSINGL );
+    CHECK( plan.reprc( 1 ) == DLIS_FDOUBL );
+    CHECK( plan.count( 0 ) == 1 );
+    CHECK( plan.offset( 1, nullptr, nullptr ) == 4 );
+}
+
+TEST_CASE("Frames keep attributes that are not in the standard") {
+    const std::vector< unsigned char > record = {
+        0xF8,
+        0x05, 0x46, 0x52, 0x41, 0x4D, 0x45, /* "FRAME" */
+        0x01, 0x30,
+
+        0x34,
+        0x08, 0x43, 0x48, 0x41, 0x4E, 0x4E, 0x45, 0x4C, 0x53, /* "CHANNELS" */
+        0x17,
+
+        0x35,
+        0x0B, 0x56, 0x45, 0x4E, 0x44, 0x4F, 0x52, 0x2D, 0x46, 0x4C, 0x41,
+        0x47, /* "VENDOR-FLAG" */
+        0x0F,
+        0x01,
+
+        0x70,
+        0x00, 0x00, 0x02, 0x46, 0x31, /* (0, 0, "F1") */
+        0x21,
+        0x00, 0x00, 0x04, 0x54, 0x49, 0x4D, 0x45, /* (0, 0, "TIME") */
+        0x21,
+        0x07,
+
+        0x70,
+        0x00, 0x00, 0x02, 0x46, 0x32, /* (0, 0, "F2") */
+        0x21,
+        0x00, 0x00, 0x04, 0x54, 0x49, 0x4D, 0x45, /* (0, 0, "TIME") */
+    };
+
+    const auto set = dl::parse_eflr( begin_of( record ),
+                                     end_of( record ),
+                                     DLIS_FRAME );
+
+    const auto& frames = boost::get< std::vector< dl::frame > >(
+        set.objects
+    );
+    REQUIRE( frames.size() == 2 );
+
+    for (const auto& frame : frames) {
+        REQUIRE( frame.channels.size() == 1 );
+        CHECK( frame.channels.front().id == dl::ident{ "TIME" } );
+        REQUIRE( frame.unknown.attributes.size() == 1 );
+        CHECK( frame.unknown.attributes.front().label
+               == dl::ident{ "VENDOR-FLAG" } );
+    }
+
+    /* F1 overrides the template value, F2 has the default */
+    const auto& f1 = frames[0].unknown.attributes.front();
+    const auto& f2 = frames[1].unknown.attributes.front();
+    CHECK( f1.value.get< dl::ushort >() == std::vector< dl::ushort >{ 7 } );
+    CHECK( f2.value.get< dl::ushort >() == std::vector< dl::ushort >{ 1 } );
+
+    std::vector< dl::object_set > sets;
+    sets.push_back( dl::parse_eflr( begin_of( stdrecord ),
+                                    end_of( stdrecord ),
+                                    DLIS_CHANNL ) );
+    const dl::channel_index index( sets );
+    const auto channels = index.resolve( frames[0] );
+    REQUIRE( channels.size() == 1 );
+    CHECK( channels[0]->get_name() == "TIME" );
+}
+
+TEST_CASE("Static sets are parsed into typed objects by set type") {
+    const std::vector< unsigned char > record = {
+        0xF8,
+        0x09, 0x50, 0x41, 0x52, 0x41, 0x4D, 0x45, 0x54, 0x45, 0x52,
+        0x01, 0x30,
+
+        /* the template does not specify reprcs */
+        0x30,
+        0x09, 0x4C, 0x4F, 0x4E, 0x47, 0x2D, 0x4E, 0x41, 0x4D, 0x45,
+        0x30,
+        0x06, 0x56, 0x41, 0x4C, 0x55, 0x45, 0x53, /* "VALUES" */
+
+        0x70,
+        0x00, 0x00, 0x02, 0x42, 0x53, /* (0, 0, "BS") */
+        0x25,
+        0x14,
+        0x08, 0x42, 0x49, 0x54, 0x20, 0x53, 0x49, 0x5A, 0x45, /* BIT SIZE */
+        0x25,
+        0x02,
+        0x41, 0x10, 0x00, 0x00, /* 9.0 */
+    };
+
+    const auto set = dl::parse_eflr( begin_of( record ),
+                                     end_of( record ),
+                                     DLIS_STATIC );
+
+    const auto& params = boost::get< std::vector< dl::parameter > >(
+        set.objects
+    );
+    REQUIRE( params.size() == 1 );
+
+    const auto& bs = params.front();
+    CHECK( bs.get_name() == "BS" );
+    CHECK( dl::decay( boost::get< dl::ascii >( bs.name ) ) == "BIT SIZE" );
+    CHECK( bs.values.get< dl::fsingl >() == std::vector< dl::fsingl >{ 9.0 } );
+}
+
+TEST_CASE("Explicit records are parsed concurrently in file order") {
+    const temp_file file( "parallel-eflrs.dlis" );
+
+    /* PAD-ARRAY's DIMENSION is missing a value */
+    const auto truncated = std::vector< unsigned char >(
+        stdrecord.begin(),
+        stdrecord.end() - 1
+    );
+
+    std::vector< std::vector< unsigned char > > bodies;
+    std::vector< std::uint8_t > types;
+    std::vector< std::uint8_t > attrs;
+    for (int i = 0; i < 40; ++i) {
+        const bool frame = i % 3 == 0;
+        bodies.push_back( frame ? framerecord : stdrecord );
+        types.push_back( frame ? DLIS_FRAME : DLIS_CHANNL );
+        attrs.push_back( i == 7 ? DLIS_SEGATTR_ENCRYPT : 0 );
+    }
+    bodies[ 22 ] = truncated;
+
+    write_eflrs( file.path, bodies, types, attrs, 100 );
+
+    dl::mapped_file fs( file.path );
+    const auto index = dl::make_index( dl::parallel_index( fs, 0, 1 ) );
+    REQUIRE( index.records.size() == bodies.size() );
+
+    /* encrypted records are not among the explicits */
+    REQUIRE( index.explicits.size() == bodies.size() - 1 );
+    std::vector< std::size_t > all( bodies.size() );
+    std::iota( all.begin(), all.end(), 0 );
+
+    const auto sameset = [&]( const dl::object_set& set, std::size_t i ) {
+        INFO( "record " << i );
+        const auto expected = dl::parse_eflr( begin_of( bodies[ i ] ),
+                                              end_of( bodies[ i ] ),
+                                              types[ i ] );
+        CHECK( set.role == expected.role );
+        CHECK( dl::decay( set.type ) == dl::decay( expected.type ) );
+        CHECK( set.tmpl.size() == expected.tmpl.size() );
+        CHECK( set.objects.which() == expected.objects.which() );
+
+        if (types[ i ] == DLIS_FRAME) {
+            using frames = std::vector< dl::frame >;
+            const auto& lhs = boost::get< frames >( set.objects );
+            const auto& rhs = boost::get< frames >( expected.objects );
+            REQUIRE( lhs.size() == rhs.size() );
+            for (std::size_t k = 0; k < lhs.size(); ++k) {
+                CHECK( lhs[ k ].object_name == rhs[ k ].object_name );
+                CHECK( lhs[ k ].channels == rhs[ k ].channels );
+            }
+        } else {
+            using channels = std::vector< dl::channel >;
+            const auto& lhs = boost::get< channels >( set.objects );
+            const auto& rhs = boost::get< channels >( expected.objects );
+            REQUIRE( lhs.size() == rhs.size() );
+            for (std::size_t k = 0; k < lhs.size(); ++k)
+                CHECK( lhs[ k ].object_name == rhs[ k ].object_name );
+        }
+    };
+
+    SECTION("the first broken record is re-thrown") {
+        CHECK_THROWS_AS( dl::parse_eflrs( fs, index, 4 ), std::out_of_range );
+    }
+
+    SECTION("broken records are reported per record") {
+        for (int threads : { 1, 2, 4, 0 }) {
+            INFO( "threads = " << threads );
+            std::vector< std::exception_ptr > errors;
+            const auto sets = dl::parse_eflrs( fs,
+                                               index.records,
+                                               all,
+                                               threads,
+                                               &errors );
+            REQUIRE( sets.size() == bodies.size() );
+            REQUIRE( errors.size() == bodies.size() );
+
+            for (std::size_t i = 0; i < sets.size(); ++i) {
+                if (i == 7 || i == 22) {
+                    CHECK( sets[ i ].tmpl.empty() );
+                    CHECK( bool( errors[ i ] ) == (i == 22) );
+                    continue;
+                }
+
+                CHECK( !errors[ i ] );
+                sameset( sets[ i ], i );
+            }
+        }
+    }
+
+    SECTION("a subset is returned in the requested order") {
+        const std::vector< std::size_t > positions = { 30, 3, 31 };
+
+        const auto sets = dl::parse_eflrs( fs, index.records, positions, 3 );
+        REQUIRE( sets.size() == 3 );
+        sameset( sets[ 0 ], 30 );
+        sameset( sets[ 1 ], 3 );
+        sameset( sets[ 2 ], 31 );
+    }
+
+}
@@ -0,0 +1,64 @@
+#ifndef DLISIO_TEST_TEMPFILE_HPP
+#define DLISIO_TEST_TEMPFILE_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string tempdir() {
+    for (const char* var : { "TMPDIR", "TMP", "TEMP" }) {
+        const char* dir = std::getenv( var );
+        if (dir && *dir) return dir;
+    }
+
+#ifdef _WIN32
+    return ".";
+#else
+    return "/tmp";
+#endif
+}
+
+/*
+ * A file in the temporary directory that is removed when it goes out of
+ * scope, also when a REQUIRE fails. Declare it before the files that map it,
+ * so that they are closed first.
+ */
+class temp_file {
+public:
+    explicit temp_file( const std::string& name ) :
+        path( tempdir() + "/dlisio-test-" + name )
+    {}
+
+    temp_file( const std::string& name, const std::vector< char >& bytes ) :
+        temp_file( name )
+    {
+        this->write( bytes );
+    }
+
+    temp_file( const temp_file& ) = delete;
+    temp_file& operator = ( const temp_file& ) = delete;
+
+    ~temp_file() {
+        std::remove( this->path.c_str() );
+    }
+
+    /* (over)write the file with the first n bytes */
+    void write( const std::vector< char >& bytes, std::size_t n ) const {
+        std::ofstream out( this->path, std::ios_base::binary );
+        out.write( bytes.data(), n );
+    }
+
+    void write( const std::vector< char >& bytes ) const {
+        this->write( bytes, bytes.size() );
+    }
+
+    const std::string path;
+};
+
+}
+
+#endif // DLISIO_TEST_TEMPFILE_HPP
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <initializer_list>
@@ -7,10 +8,13 @@
 #include <limits>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <catch2/catch.hpp>
 
+#include <dlisio/dlisio.h>
 #include <dlisio/types.h>
+#include <dlisio/ext/types.hpp>
 
 /*
  * Custom type for byte arrays, for nicely printing mismatch between expected
@@ -1509,3 +1513,385 @@ TEST_CASE( "size-of", "[type]" ) {
     CHECK( dlis_sizeof_type( DLIS_STATUS ) == 1 );
     CHECK( dlis_sizeof_type( DLIS_UNITS  ) == 0 );
 }
+
+namespace {
+
+/*
+ * A deterministic, arbitrary byte pattern. All bit patterns are valid input,
+ * including NaNs and denormals, so the bulk decoders are compared to the
+ * scalar ones bit-by-bit rather than by value
+ */
+std::vector< char > noise( std::size_t size ) {
+    std::vector< char > xs( size );
+    std::uint32_t state = 2463534242;
+    for( auto& x : xs ) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        x = char( state );
+    }
+    return xs;
+}
+
+template< typename T, typename Scalar, typename Bulk >
+void check_bulk( Scalar scalar, Bulk bulk ) {
+    const auto source = noise( 130 * sizeof( T ) + 1 );
+
+    /*
+     * Cover every tail length of the widest (64-byte) kernel, and unaligned
+     * input
+     */
+    for( std::size_t offset = 0; offset < 2; ++offset ) {
+        for( std::size_t n = 0; n < 130; ++n ) {
+            const char* xs = source.data() + offset;
+            std::vector< T > expected( n );
+            std::vector< T > result( n );
+
+            const char* cur = xs;
+            for( auto& x : expected ) cur = scalar( cur, &x );
+
+            const char* end = bulk( xs, n, result.data() );
+            CHECK( end == cur );
+
+            /*
+             * compare bytes, as the noise has NaNs. data() may be null when
+             * there's nothing to compare, which memcmp doesn't allow
+             */
+            if( n == 0 ) continue;
+            CHECK( std::memcmp( expected.data(),
+                                result.data(),
+                                n * sizeof( T ) ) == 0 );
+        }
+    }
+}
+
+}
+
+TEST_CASE( "bulk decoders match the scalar ones", "[type]" ) {
+    SECTION( "snorm" )  { check_bulk< std::int16_t >( dlis_snorm, dlis_snorm_n ); }
+    SECTION( "slong" )  { check_bulk< std::int32_t >( dlis_slong, dlis_slong_n ); }
+    SECTION( "unorm" )  { check_bulk< std::uint16_t >( dlis_unorm, dlis_unorm_n ); }
+    SECTION( "ulong" )  { check_bulk< std::uint32_t >( dlis_ulong, dlis_ulong_n ); }
+    SECTION( "fsingl" ) { check_bulk< float >( dlis_fsingl, dlis_fsingl_n ); }
+    SECTION( "fdoubl" ) { check_bulk< double >( dlis_fdoubl, dlis_fdoubl_n ); }
+    SECTION( "isingl" ) { check_bulk< float >( dlis_isingl, dlis_isingl_n ); }
+    SECTION( "fshort" ) { check_bulk< float >( dlis_fshort, dlis_fshort_n ); }
+    SECTION( "vsingl" ) { check_bulk< float >( dlis_vsingl, dlis_vsingl_n ); }
+}
+
+TEST_CASE( "bulk fshort matches the scalar one for all inputs", "[type]" ) {
+    std::vector< char > source( 0x10000 * 2 );
+    for( std::uint32_t i = 0; i < 0x10000; ++i )
+        dlis_unormo( source.data() + 2 * i, std::uint16_t( i ) );
+
+    std::vector< float > expected( 0x10000 );
+    std::vector< float > result( 0x10000 );
+    for( std::size_t i = 0; i < expected.size(); ++i )
+        dlis_fshort( source.data() + 2 * i, &expected[ i ] );
+
+    dlis_fshort_n( source.data(), result.size(), result.data() );
+    CHECK( std::memcmp( expected.data(),
+                        result.data(),
+                        result.size() * sizeof( float ) ) == 0 );
+}
+
+TEST_CASE( "bulk vax floats match the scalar ones across the range", "[type]" ) {
+    /*
+     * Every exponent, both signs, in VAX byte order. Exponents 0, 1 and 2
+     * are the zero/reserved and denormal special cases
+     */
+    std::vector< char > source;
+    for( std::uint32_t sign = 0; sign < 2; ++sign )
+    for( std::uint32_t exp = 0; exp < 0x100; ++exp )
+    for( std::uint32_t frac : { 0x000000u, 0x000001u, 0x7FFFFFu, 0x2ABCDEu } ) {
+        const std::uint32_t v = sign << 31 | exp << 23 | frac;
+        source.push_back( char( v >> 16 ) );
+        source.push_back( char( v >> 24 ) );
+        source.push_back( char( v >>  0 ) );
+        source.push_back( char( v >>  8 ) );
+    }
+
+    const auto n = source.size() / 4;
+    std::vector< float > expected( n );
+    std::vector< float > result( n );
+    for( std::size_t i = 0; i < n; ++i )
+        dlis_vsingl( source.data() + 4 * i, &expected[ i ] );
+
+    dlis_vsingl_n( source.data(), n, result.data() );
+    CHECK( std::memcmp( expected.data(),
+                        result.data(),
+                        n * sizeof( float ) ) == 0 );
+}
+
+TEST_CASE( "bulk ibm floats match the scalar ones across the range", "[type]" ) {
+    /*
+     * Walk the exponent and the top mantissa bits, which select the it/mt
+     * entries, and both signs. This covers the overflow and underflow clamps
+     */
+    std::vector< std::uint32_t > inputs;
+    for( std::uint32_t sign = 0; sign < 2; ++sign )
+    for( std::uint32_t exp = 0; exp < 0x80; ++exp )
+    for( std::uint32_t top = 0; top < 8; ++top )
+    for( std::uint32_t low : { 0x000000u, 0x000001u, 0x1FFFFFu, 0x0ABCDEu } )
+        inputs.push_back( sign << 31 | exp << 24 | top << 21 | low );
+
+    std::vector< char > source( inputs.size() * 4 );
+    for( std::size_t i = 0; i < inputs.size(); ++i )
+        dlis_ulongo( source.data() + 4 * i, inputs[ i ] );
+
+    std::vector< float > expected( inputs.size() );
+    std::vector< float > result( inputs.size() );
+    for( std::size_t i = 0; i < inputs.size(); ++i )
+        dlis_isingl( source.data() + 4 * i, &expected[ i ] );
+
+    dlis_isingl_n( source.data(), inputs.size(), result.data() );
+    CHECK( std::memcmp( expected.data(),
+                        result.data(),
+                        result.size() * sizeof( float ) ) == 0 );
+}
+
+TEST_CASE( "bulk ibm float throughput", "[.benchmark]" ) {
+    const std::size_t n = 1 << 22;
+    const auto source = noise( n * 4 );
+    std::vector< float > out( n );
+
+    using clock = std::chrono::steady_clock;
+    const auto t0 = clock::now();
+    for( std::size_t i = 0; i < n; ++i )
+        dlis_isingl( source.data() + 4 * i, &out[ i ] );
+    const auto t1 = clock::now();
+    dlis_isingl_n( source.data(), n, out.data() );
+    const auto t2 = clock::now();
+
+    using ms = std::chrono::duration< double, std::milli >;
+    const auto scalar = ms( t1 - t0 ).count();
+    const auto bulk   = ms( t2 - t1 ).count();
+    WARN( "dlis_isingl:   " << scalar << " ms" );
+    WARN( "dlis_isingl_n: " << bulk << " ms" );
+    WARN( "speedup:       " << scalar / bulk << "x" );
+}
+
+namespace {
+
+template< typename T, typename Scalar >
+void check_strided( int reprc,
+                    std::size_t components,
+                    Scalar scalar,
+                    std::size_t stride,
+                    std::size_t offset,
+                    std::size_t count,
+                    std::size_t nframes ) {
+    const auto source = noise( stride * nframes + offset + 64 );
+    const char* base = source.data();
+
+    std::vector< T > expected;
+    for( std::size_t i = 0; i < nframes; ++i ) {
+        const char* cur = base + i * stride + offset;
+        for( std::size_t k = 0; k < count * components; ++k ) {
+            T x;
+            cur = scalar( cur, &x );
+            expected.push_back( x );
+        }
+    }
+
+    std::vector< T > result( expected.size() );
+    const auto err = dlis_decode_strided( reprc,
+                                          base,
+                                          stride,
+                                          offset,
+                                          count,
+                                          nframes,
+                                          result.data() );
+    CHECK( err == 0 );
+
+    /* with no frames or no values, data() may be null, which memcmp rejects */
+    if( result.empty() ) return;
+    CHECK( std::memcmp( expected.data(),
+                        result.data(),
+                        result.size() * sizeof( T ) ) == 0 );
+}
+
+}
+
+TEST_CASE( "strided decode matches the scalar parsers", "[type]" ) {
+    /*
+     * Frames of a single channel are contiguous, small channels are staged
+     * in blocks (and 1000 frames span several blocks), and large channels are
+     * decoded in place
+     */
+    for( std::size_t nframes : { 0, 1, 7, 1000 } ) {
+        check_strided< float >( DLIS_FSINGL, 1, dlis_fsingl, 4, 0, 1, nframes );
+        check_strided< float >( DLIS_FSINGL, 1, dlis_fsingl, 23, 5, 1, nframes );
+        check_strided< float >( DLIS_FSINGL, 1, dlis_fsingl, 1203, 3, 300, nframes );
+        check_strided< float >( DLIS_FSHORT, 1, dlis_fshort, 9, 1, 3, nframes );
+        check_strided< float >( DLIS_ISINGL, 1, dlis_isingl, 17, 8, 2, nframes );
+        check_strided< float >( DLIS_VSINGL, 1, dlis_vsingl, 17, 8, 2, nframes );
+        check_strided< float >( DLIS_FSING1, 2, dlis_fsingl, 30, 2, 1, nframes );
+        check_strided< float >( DLIS_CSINGL, 2, dlis_fsingl, 30, 2, 2, nframes );
+        check_strided< double >( DLIS_FDOUBL, 1, dlis_fdoubl, 41, 11, 3, nframes );
+        check_strided< double >( DLIS_FDOUB2, 3, dlis_fdoubl, 80, 1, 2, nframes );
+        check_strided< std::int8_t >( DLIS_SSHORT, 1, dlis_sshort, 5, 4, 1, nframes );
+        check_strided< std::int16_t >( DLIS_SNORM, 1, dlis_snorm, 6, 2, 2, nframes );
+        check_strided< std::uint32_t >( DLIS_ULONG, 1, dlis_ulong, 12, 0, 1, nframes );
+    }
+}
+
+TEST_CASE( "strided decode rejects variable-size types", "[type]" ) {
+    char buffer[ 8 ] = {};
+    char out[ 64 ];
+    CHECK( dlis_decode_strided( DLIS_IDENT, buffer, 8, 0, 1, 1, out ) < 0 );
+    CHECK( dlis_decode_strided( DLIS_DTIME, buffer, 8, 0, 1, 1, out ) < 0 );
+    CHECK( dlis_decode_strided( 0, buffer, 8, 0, 1, 1, out ) < 0 );
+}
+
+TEST_CASE( "skip variable-length values", "[type]" ) {
+    /*
+     * uvari (1, 2 and 4 bytes), ident, ascii, obname, objref, attref
+     */
+    const unsigned char data[] = {
+        0x01,
+        0x81, 0x00,
+        0xC0, 0x00, 0x00, 0x01,
+        0x03, 'A', 'B', 'C',
+        0x02, 'X', 'Y',
+        0x01, 0x00, 0x02, 'I', 'D',
+        0x01, 'T', 0x01, 0x00, 0x02, 'I', 'D',
+        0x01, 'T', 0x81, 0x00, 0x00, 0x00, 0x01, 'L',
+    };
+    const char* xs = reinterpret_cast< const char* >( data );
+
+    const char* uvari = dlis_skip( DLIS_UVARI, xs, 3 );
+    CHECK( uvari == xs + 7 );
+
+    const char* ident = dlis_skip( DLIS_IDENT, uvari, 1 );
+    CHECK( ident == uvari + 4 );
+
+    const char* ascii = dlis_skip( DLIS_ASCII, ident, 1 );
+    CHECK( ascii == ident + 3 );
+
+    std::int32_t origin, idlen;
+    std::uint8_t copy;
+    const char* obname = dlis_skip( DLIS_OBNAME, ascii, 1 );
+    CHECK( obname == dlis_obname( ascii, &origin, &copy, &idlen, nullptr ) );
+
+    const char* objref = dlis_skip( DLIS_OBJREF, obname, 1 );
+    CHECK( objref == obname + 7 );
+
+    const char* attref = dlis_skip( DLIS_ATTREF, objref, 1 );
+    CHECK( attref == xs + sizeof( data ) );
+
+    CHECK( dlis_skip( DLIS_FDOUBL, xs, 3 ) == xs + 24 );
+    CHECK( dlis_skip( 0, xs, 1 ) == nullptr );
+    CHECK( dlis_skip( 28, xs, 1 ) == nullptr );
+}
+
+TEST_CASE( "bounded skip stops at the end of the buffer", "[type]" ) {
+    /* the same values as above, which must all fit exactly */
+    const unsigned char data[] = {
+        0x01,
+        0x81, 0x00,
+        0xC0, 0x00, 0x00, 0x01,
+        0x03, 'A', 'B', 'C',
+        0x02, 'X', 'Y',
+        0x01, 0x00, 0x02, 'I', 'D',
+        0x01, 'T', 0x01, 0x00, 0x02, 'I', 'D',
+        0x01, 'T', 0x81, 0x00, 0x00, 0x00, 0x01, 'L',
+    };
+    const char* xs = reinterpret_cast< const char* >( data );
+
+    for (std::size_t cut = 0; cut <= sizeof( data ); ++cut) {
+        const char* end = xs + cut;
+        const char* ptr = dlis_skip_bounded( DLIS_UVARI, xs, end, 3 );
+        ptr = dlis_skip_bounded( DLIS_IDENT,  ptr, end, 1 );
+        ptr = dlis_skip_bounded( DLIS_ASCII,  ptr, end, 1 );
+        ptr = dlis_skip_bounded( DLIS_OBNAME, ptr, end, 1 );
+        ptr = dlis_skip_bounded( DLIS_OBJREF, ptr, end, 1 );
+        ptr = dlis_skip_bounded( DLIS_ATTREF, ptr, end, 1 );
+
+        INFO( "buffer cut at " << cut );
+        if (cut == sizeof( data ))
+            CHECK( ptr == end );
+        else
+            CHECK( ptr == nullptr );
+    }
+
+    CHECK( dlis_skip_bounded( DLIS_FDOUBL, xs, xs + 24, 3 ) == xs + 24 );
+    CHECK( dlis_skip_bounded( DLIS_FDOUBL, xs, xs + 23, 3 ) == nullptr );
+    CHECK( dlis_skip_bounded( DLIS_FDOUBL, xs, xs, 0 ) == xs );
+    CHECK( dlis_skip_bounded( 0, xs, xs + 8, 1 ) == nullptr );
+}
+
+TEST_CASE( "frame offsets", "[type]" ) {
+    /* fsingl[2], ident, unorm, ascii[2], fdoubl */
+    const unsigned char data[] = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x02, 'A', 'B',
+        0x00, 0x01,
+        0x01, 'X', 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    };
+    const char* xs = reinterpret_cast< const char* >( data );
+
+    const std::int32_t counts[] = { 2, 1, 1, 2, 1 };
+    const std::int32_t reprcs[] = {
+        DLIS_FSINGL, DLIS_IDENT, DLIS_UNORM, DLIS_ASCII, DLIS_FDOUBL
+    };
+
+    const char* end = xs + sizeof( data );
+
+    std::size_t offsets[ 6 ];
+    CHECK( dlis_frame_offsets( xs, end, 5, counts, reprcs, offsets ) == DLIS_OK );
+    CHECK( offsets[ 0 ] == 0 );
+    CHECK( offsets[ 1 ] == 8 );
+    CHECK( offsets[ 2 ] == 11 );
+    CHECK( offsets[ 3 ] == 13 );
+    CHECK( offsets[ 4 ] == 16 );
+    CHECK( offsets[ 5 ] == sizeof( data ) );
+
+    const std::int32_t bad[] = { DLIS_FSINGL, 0 };
+    CHECK( dlis_frame_offsets( xs, end, 2, counts, bad, offsets )
+           == DLIS_UNEXPECTED_VALUE );
+
+    const std::int32_t negative[] = { 2, -1 };
+    CHECK( dlis_frame_offsets( xs, end, 2, negative, reprcs, offsets )
+           == DLIS_UNEXPECTED_VALUE );
+
+    /* neither fixed- nor variable-size channels are read past end */
+    CHECK( dlis_frame_offsets( xs, xs + 7, 1, counts, reprcs, offsets )
+           == DLIS_TRUNCATED );
+    CHECK( dlis_frame_offsets( xs, xs + 10, 2, counts, reprcs, offsets )
+           == DLIS_TRUNCATED );
+    CHECK( dlis_frame_offsets( xs, end - 1, 5, counts, reprcs, offsets )
+           == DLIS_TRUNCATED );
+
+    /* a bogus length is caught, even when end is far away */
+    std::vector< char > bogus( xs, end );
+    bogus[ 8 ] = char( 0xFF );
+    CHECK( dlis_frame_offsets( bogus.data(), bogus.data() + bogus.size(),
+                               5, counts, reprcs, offsets )
+           == DLIS_TRUNCATED );
+}
+
+namespace {
+
+struct reprc_of {
+    using result_type = dl::representation_code;
+
+    template< typename T >
+    dl::representation_code operator()() const {
+        return dl::typeinfo< T >::reprc;
+    }
+};
+
+}
+
+TEST_CASE( "representation code dispatch", "[type]" ) {
+    const reprc_of vis{};
+    for( int x = DLIS_FSHORT; x <= DLIS_UNITS; ++x ) {
+        const auto reprc = static_cast< dl::representation_code >( x );
+        CHECK( dl::visit_reprc( reprc, vis ) == reprc );
+    }
+
+    const auto invalid = static_cast< dl::representation_code >( 0 );
+    CHECK_THROWS_AS( dl::visit_reprc( invalid, vis ), std::invalid_argument );
+}
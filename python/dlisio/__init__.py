@@ -1,3 +1,4 @@
+import os
 import numpy as np
 from . import core
 
@@ -8,14 +9,120 @@ try:
 except pkg_resources.DistributionNotFound:
     pass
 
-def load(path):
-    return dlis(path)
+def sidecar(path, cache):
+    """Path of the index file for path
+
+    Parameters
+    ----------
+    path : str
+        path of the dlis file
+    cache : bool or str
+        False for no index file, True for an index file next to the dlis
+        file, or the directory to store the index file in
+
+    Returns
+    -------
+    sidecar : str
+        path of the index file, or the empty string if cache is False
+    """
+    if not cache:
+        return ''
+
+    name = os.path.basename(path) + '.dlisio-index'
+    if cache is True:
+        return os.path.join(os.path.dirname(path), name)
+
+    return os.path.join(cache, name)
+
+class explicits(object):
+    """Explicitly formatted logical records, parsed on demand
+
+    The records are parsed the first time they're accessed, and the parsed
+    record is cached. Indexing the file only records where the explicit
+    records are, and their logical record type, so finding the records of a
+    certain type, e.g. all the channels, does not require parsing the rest.
+
+    Indexing raises if the record can not be parsed, while iterating, with
+    for or oftype, reports and skips it.
+
+    Parameters
+    ----------
+    fp : core.file
+    bookmarks : core.index
+    positions : array_like of int
+        the positions of the explicit records in bookmarks
+    """
+    # logical record types, from the RP66 v1 appendix A
+    CHANNL = 3
+    FRAME = 4
+
+    def __init__(self, fp, bookmarks, positions):
+        self.fp = fp
+        self.bookmarks = bookmarks
+        self.positions = positions
+        self.parsed = {}
+
+    def __len__(self):
+        return len(self.positions)
+
+    def __getitem__(self, i):
+        if i < 0:
+            i += len(self)
+
+        if not 0 <= i < len(self):
+            raise IndexError('explicit record index out of range')
+
+        if i not in self.parsed:
+            mark = self.bookmarks[int(self.positions[i])]
+            self.parsed[i] = self.fp.eflr(mark)
+
+        return self.parsed[i]
+
+    def __iter__(self):
+        """The records that can be parsed, in file order
+
+        Like the eagerly parsed index used to, records that can not be parsed
+        are reported and skipped. Use indexing to get the exception instead.
+        """
+        for _, record in self.parsable(lambda pos: True):
+            yield record
+
+    def oftype(self, rectype):
+        """The records of type rectype, as (position, record) pairs
+
+        Records that can not be parsed are reported and skipped.
+        """
+        types = self.bookmarks.type
+        return self.parsable(lambda pos: types[pos] == rectype)
+
+    def parsable(self, keep):
+        for i, pos in enumerate(self.positions):
+            if not keep(pos):
+                continue
+
+            try:
+                record = self[i]
+            except Exception as e:
+                print(e, ' at ', int(pos) + 1)
+                continue
+
+            yield i, record
+
+def load(path, threads=1, cache=False, recover=False):
+    return dlis(path, threads, cache, recover)
 
 class dlis(object):
-    def __init__(self, path):
+    def __init__(self, path, threads=1, cache=False, recover=False):
         self.fp = core.file(path)
         self.sul = self.fp.sul()
-        self.bookmarks, self.explicits, self.implicits = self.fp.mkindex()
+        self.threads = threads
+        index = self.fp.mkindex(threads=threads,
+                                sidecar=sidecar(path, cache),
+                                recover=recover)
+        self.bookmarks, positions, self.implicits = index
+        self.explicits = explicits(self.fp, self.bookmarks, positions)
+        self.frame_table = None
+        self.plans = {}
 
     def raw_record(self, i):
         """Get a raw record (as bytes)
@@ -58,30 +165,69 @@ class dlis(object):
         self.fp.close()
 
     def getcurves(self, key):
-        _, channels = self.channels_matching(key)
-
         curves = {}
-        for chs in channels.values():
-            channel = chs[-1]
-            root = channel['root']
-            elems = channel['len'][0]
-            dtype = channel['repr'][0]
+        for root, channels in self.frames().items():
+            ids = [channel[2] for channel in channels]
+            if key not in ids:
+                continue
 
+            plan = self.frameplan(root)
             implicits = self.implicits[root]
+            a = self.fp.curves(self.bookmarks, implicits, plan, ids.index(key))
+            curves[root] = np.array(a)
 
-            pre = [(c['len'][0], c['repr'][0]) for c in chs[:-1]]
+        if len(curves) == 0:
+            raise ValueError('found no frame with the CHANNEL {}'.format(key))
 
-            a = []
-            for implicit in implicits:
-                a.append(self.fp.iflr(implicit, pre, elems, dtype))
+        return curves
 
-            curves[root] = np.array(a)
+    def frames(self):
+        """The channels of every frame, in frame order, by frame name
 
-        return curves
+        The CHANNEL and FRAME sets are parsed, and the channels of every frame
+        resolved, in one pass in the extension, which also compiles the frame
+        plans.
+
+        Returns
+        -------
+        frames : dict
+        """
+        if self.frame_table is not None:
+            return self.frame_table
+
+        positions = self.explicits.positions
+        resolved = self.fp.frameplans(self.bookmarks,
+                                      positions,
+                                      threads=self.threads)
+
+        self.frame_table = {}
+        for name, (channels, plan) in resolved.items():
+            self.frame_table[name] = channels
+            self.plans[name] = plan
+
+        return self.frame_table
+
+    def frameplan(self, name):
+        """The compiled frame layout, for decoding the frame's records
+
+        The plan is built once per frame from the representation code and
+        size of its channels, and re-used for every curve in the frame.
+
+        Parameters
+        ----------
+        name : tuple
+            the frame name, as (origin, copy, id)
+
+        Returns
+        -------
+        plan : core.frameplan
+        """
+        self.frames()
+        return self.plans[name]
 
     def channel_metadata(self, objname):
         out = {}
-        for ex in self.explicits:
+        for _, ex in self.explicits.oftype(explicits.CHANNL):
             if ex['type'] != 'CHANNEL':
                 continue
 
@@ -101,7 +247,7 @@ class dlis(object):
 
     def channels_matching(self, key):
         positions = {}
-        for exi, ex in enumerate(self.explicits):
+        for exi, ex in self.explicits.oftype(explicits.FRAME):
             if ex['type'] != 'FRAME':
                 continue
             for name, properties in ex['objects'].items():
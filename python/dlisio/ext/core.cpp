@@ -7,11 +7,14 @@
 #include <fstream>
 #include <iterator>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <system_error>
 #include <vector>
 
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include <datetime.h>
 
 #include <dlisio/dlisio.h>
@@ -24,7 +27,7 @@ using namespace py::literals;
 #include <dlisio/ext/io.hpp>
 #include <dlisio/ext/types.hpp>
 
-using File = dl::basic_file< std::ifstream >;
+using File = dl::mapped_file;
 
 namespace pybind11 { namespace detail {
 template <> struct type_caster< dl::dtime > {
@@ -83,6 +86,8 @@ long origin( const char*& xs ) noexcept;
 std::tuple< long, int, std::string > obname( const char*& xs );
 std::tuple< long, int, std::string > obname( const char*& xs, int nmemb );
 std::tuple< std::string, long, int, std::string > objref( const char*& xs );
+std::tuple< std::string, long, int, std::string, std::string >
+attref( const char*& xs );
 
 int status( const char*& xs ) noexcept;
 
@@ -299,6 +304,30 @@ std::tuple< std::string, long, int, std::string > objref( const char*& xs ) {
     );
 }
 
+std::tuple< std::string, long, int, std::string, std::string >
+attref( const char*& xs ) {
+    char strid1[ 256 ];
+    char strobj[ 256 ];
+    char strid2[ 256 ];
+    std::int32_t lenid1;
+    std::int32_t lenobj;
+    std::int32_t lenid2;
+
+    std::int32_t orig;
+    std::uint8_t copy;
+
+    xs = dlis_attref( xs,
+                      &lenid1, strid1,
+                      &orig, &copy, &lenobj, strobj,
+                      &lenid2, strid2 );
+
+    return std::make_tuple(
+        std::string( strid1, strid1 + lenid1 ),
+        orig, copy, std::string( strobj, strobj + lenobj ),
+        std::string( strid2, strid2 + lenid2 )
+    );
+}
+
 int status( const char*& xs ) noexcept {
     std::uint8_t x;
     xs = dlis_status( xs, &x );
@@ -307,6 +336,81 @@ int status( const char*& xs ) noexcept {
 
 }
 
+/*
+ * The python conversion of every representation code, keyed on the dl type,
+ * so that the loops over values can be written once and have the type
+ * resolved by dl::visit_reprc
+ */
+template< typename T > struct converter;
+
+#define DLIS_REGISTER_CONVERTER(type, fn) \
+    template<> struct converter< dl::type > { \
+        static py::object read( const char*& xs ) { \
+            return py::cast( conv::fn( xs ) ); \
+        } \
+    };
+
+DLIS_REGISTER_CONVERTER(fshort, fshort)
+DLIS_REGISTER_CONVERTER(fsingl, fsingl)
+DLIS_REGISTER_CONVERTER(fsing1, fsing1)
+DLIS_REGISTER_CONVERTER(fsing2, fsing2)
+DLIS_REGISTER_CONVERTER(isingl, isingl)
+DLIS_REGISTER_CONVERTER(vsingl, vsingl)
+DLIS_REGISTER_CONVERTER(fdoubl, fdoubl)
+DLIS_REGISTER_CONVERTER(fdoub1, fdoub1)
+DLIS_REGISTER_CONVERTER(fdoub2, fdoub2)
+DLIS_REGISTER_CONVERTER(csingl, csingl)
+DLIS_REGISTER_CONVERTER(cdoubl, cdoubl)
+DLIS_REGISTER_CONVERTER(sshort, sshort)
+DLIS_REGISTER_CONVERTER(snorm, snorm)
+DLIS_REGISTER_CONVERTER(slong, slong)
+DLIS_REGISTER_CONVERTER(ushort, ushort)
+DLIS_REGISTER_CONVERTER(unorm, unorm)
+DLIS_REGISTER_CONVERTER(ulong, ulong)
+DLIS_REGISTER_CONVERTER(uvari, uvari)
+DLIS_REGISTER_CONVERTER(ident, ident)
+DLIS_REGISTER_CONVERTER(ascii, ascii)
+DLIS_REGISTER_CONVERTER(dtime, dtime)
+DLIS_REGISTER_CONVERTER(origin, origin)
+DLIS_REGISTER_CONVERTER(obname, obname)
+DLIS_REGISTER_CONVERTER(objref, objref)
+DLIS_REGISTER_CONVERTER(attref, attref)
+DLIS_REGISTER_CONVERTER(status, status)
+DLIS_REGISTER_CONVERTER(units, ident)
+
+#undef DLIS_REGISTER_CONVERTER
+
+dl::representation_code representation( int reprc ) {
+    if( reprc < DLIS_FSHORT || reprc > DLIS_UNITS )
+        throw py::value_error( "unknown representation code "
+                             + std::to_string( reprc ) );
+
+    return static_cast< dl::representation_code >( reprc );
+}
+
+struct read_value {
+    using result_type = py::object;
+    const char*& xs;
+
+    template< typename T >
+    py::object operator()() const {
+        return converter< T >::read( this->xs );
+    }
+};
+
+struct append_values {
+    using result_type = void;
+    const char*& xs;
+    int count;
+    py::list& out;
+
+    template< typename T >
+    void operator()() const {
+        for( int i = 0; i < this->count; ++i )
+            this->out.append( converter< T >::read( this->xs ) );
+    }
+};
+
 py::dict SUL( const char* buffer ) {
     char id[ 61 ] = {};
     int seqnum, major, minor, layout;
@@ -363,175 +467,169 @@ public:
     void close() { this->fs.close(); }
 
     py::dict sul();
-    py::tuple mkindex();
+    py::tuple mkindex( int threads, const std::string& sidecar, bool recover );
     py::bytes raw_record( const dl::bookmark& );
     py::dict eflr( const dl::bookmark& );
     py::object iflr_chunk( const dl::bookmark& mark, const std::vector< std::tuple< int, int > >&, int, int );
+    py::object iflr_batch( const dl::record_index&, const std::vector< std::size_t >&, const std::vector< std::tuple< int, int > >&, int, int );
+    py::object curves( const dl::record_index&, const std::vector< std::size_t >&, const dl::frame_plan&, std::size_t );
+    py::dict frameplans( const dl::record_index&,
+                         const std::vector< std::size_t >&,
+                         int threads );
 
 
 private:
+    std::string path;
     File fs;
+
+    /*
+     * the most recently read record. Unsegmented records are read directly
+     * from the file, segmented records are concatenated into scratch
+     */
+    dl::record_view record;
+    std::vector< char > scratch;
+
+    const char* record_at( const dl::bookmark& );
 };
 
-file::file( const std::string& path ) : fs( path ) {}
+file::file( const std::string& p ) try : path( p ), fs( p ) {
+} catch( const std::system_error& e ) {
+    throw io_error( e.what() );
+}
 
 py::dict file::sul() {
     auto sulbuffer = this->fs.read< 80 >();
     return SUL( sulbuffer.data() );
 }
 
-py::tuple file::mkindex() {
-    std::vector< dl::bookmark > bookmarks;
-    std::vector< py::dict > explicits;
-    py::dict implicit_refs;
-    int remaining = 0;
+py::tuple file::mkindex( int threads,
+                         const std::string& sidecar,
+                         bool recover ) {
+    dl::file_index index;
 
-    while( !this->fs.eof() ) {
-        auto mark = tag( this->fs, remaining );
-        bookmarks.push_back( std::move( mark.second ) );
-        remaining = mark.first;
+    const bool cached = !sidecar.empty()
+                     && dl::read_index( sidecar, this->path, index );
+
+    if( !cached ) {
+        /*
+         * the parallel indexer can't recover from damage, so recovering
+         * implies a sequential scan
+         */
+        if( threads == 1 || recover ) {
+            dl::record_index records;
+            dl::vrl_table vrls;
+            dl::scan_state state;
+            state.pos = this->fs.tell();
+            dl::bookmark mark;
+
+            while( true ) {
+                const auto err = dl::scan_record( this->fs, state, mark, &vrls );
+                if( err == DLIS_OK ) {
+                    records.push_back( mark );
+                    continue;
+                }
+
+                if( err == DLIS_EOF ) break;
+
+                const auto damaged = state.pos;
+                if( recover && dl::resync( this->fs, state, &vrls ) ) {
+                    py::print( "skipped damaged bytes",
+                               damaged, "to", state.pos );
+                    continue;
+                }
+
+                if( err == DLIS_TRUNCATED ) {
+                    /* keep what's been indexed so far */
+                    py::print( "file truncated: incomplete record at",
+                               state.pos,
+                               "after", records.size(), "records" );
+                    break;
+                }
+
+                if( recover ) break;
+
+                throw std::runtime_error(
+                    "inconsistent record at " + std::to_string( state.pos )
+                );
+            }
 
-        const auto& last = bookmarks.back();
+            this->fs.seek( state.pos );
+            index = dl::make_index( std::move( records ) );
+            index.vrls = std::move( vrls );
+        } else {
+            /*
+             * the parallel indexer drops an incomplete record at the end
+             * like the sequential scan does, so report it the same way
+             */
+            dl::index_report report;
+            {
+                py::gil_scoped_release nogil;
+                dl::vrl_table vrls;
+                index = dl::make_index( dl::parallel_index( this->fs,
+                                                            this->fs.tell(),
+                                                            threads,
+                                                            &report,
+                                                            &vrls ) );
+                index.vrls = std::move( vrls );
+            }
 
-        if ( last.isencrypted ) continue;
+            if( report.truncated >= 0 ) {
+                py::print( "file truncated: incomplete record at",
+                           report.truncated,
+                           "after", index.records.size(), "records" );
+            }
+        }
 
-        if( last.isexplicit ) try {
-            explicits.push_back( this->eflr( last ) );
+        if( !sidecar.empty() ) try {
+            dl::write_index( sidecar, this->path, index );
         } catch( std::exception& e ) {
-            py::print(e.what(), " at ", bookmarks.size() );
+            py::print( e.what() );
         }
+    }
 
-        if ( last.isexplicit ) continue;
+    /*
+     * the explicit records are not parsed here, but on demand, so only
+     * report where they are
+     */
+    const auto explicits = py::array_t< std::size_t >( index.explicits.size(),
+                                                       index.explicits.data() );
 
-        const auto name = py::make_tuple(
-            static_cast< std::int32_t >( last.name.origin ),
-            static_cast< std::uint8_t >( last.name.copy ),
-            static_cast< const std::string& >( last.name.id )
+    /*
+     * the implicit records are referred to by their position in the index,
+     * grouped by name
+     */
+    py::dict implicit_refs;
+    for( std::size_t k = 0; k < index.implicits.size(); ++k ) {
+        const auto& name = index.records.names[ k ];
+        const auto key = py::make_tuple(
+            static_cast< std::int32_t >( name.origin ),
+            static_cast< std::uint8_t >( name.copy ),
+            static_cast< const std::string& >( name.id )
         );
 
-        if( !implicit_refs.contains( name ) )
-            implicit_refs[ name ] = py::list();
-
-        implicit_refs[ name ].cast< py::list >().append( last );
+        const auto& group = index.implicits[ k ];
+        implicit_refs[ key ] = py::array_t< std::size_t >( group.size(),
+                                                           group.data() );
     }
 
-    return py::make_tuple( bookmarks, explicits, implicit_refs );
+    return py::make_tuple( std::move( index.records ),
+                           explicits,
+                           implicit_refs );
 }
 
 py::object convert( int reprc, py::buffer b ) {
     const auto* xs = static_cast< const char* >( b.request().ptr );
-    switch( reprc ) {
-        case DLIS_FSHORT: return py::cast( conv::fshort( xs ) );
-        case DLIS_FSINGL: return py::cast( conv::fsingl( xs ) );
-        case DLIS_FSING1: return py::cast( conv::fsing1( xs ) );
-        case DLIS_FSING2: return py::cast( conv::fsing2( xs ) );
-        case DLIS_ISINGL: return py::cast( conv::isingl( xs ) );
-        case DLIS_VSINGL: return py::cast( conv::vsingl( xs ) );
-        case DLIS_FDOUBL: return py::cast( conv::fdoubl( xs ) );
-        case DLIS_FDOUB1: return py::cast( conv::fdoub1( xs ) );
-        case DLIS_FDOUB2: return py::cast( conv::fdoub2( xs ) );
-        case DLIS_CSINGL: return py::cast( conv::csingl( xs ) );
-        case DLIS_CDOUBL: return py::cast( conv::cdoubl( xs ) );
-        case DLIS_SSHORT: return py::cast( conv::sshort( xs ) );
-        case DLIS_SNORM:  return py::cast( conv:: snorm( xs ) );
-        case DLIS_SLONG:  return py::cast( conv:: slong( xs ) );
-        case DLIS_USHORT: return py::cast( conv::ushort( xs ) );
-        case DLIS_UNORM:  return py::cast( conv:: unorm( xs ) );
-        case DLIS_ULONG:  return py::cast( conv:: ulong( xs ) );
-        case DLIS_UVARI:  return py::cast( conv:: uvari( xs ) );
-        case DLIS_IDENT:  return py::cast( conv:: ident( xs ) );
-        case DLIS_ASCII:  return py::cast( conv:: ascii( xs ) );
-        case DLIS_DTIME:  return py::cast( conv:: dtime( xs ) );
-        case DLIS_STATUS: return py::cast( conv::status( xs ) );
-        case DLIS_ORIGIN: return py::cast( conv::origin( xs ) );
-        case DLIS_OBNAME: return py::cast( conv::obname( xs ) );
-        case DLIS_OBJREF: return py::cast( conv::objref( xs ) );
-        case DLIS_UNITS:  return py::cast( conv:: ident( xs ) );
-
-        default:
-            throw py::value_error( "unknown representation code "
-                                 + std::to_string( reprc ) );
-    }
+    const read_value vis{ xs };
+    return dl::visit_reprc( representation( reprc ), vis );
 }
 
 py::list getarray( const char*& xs, int count, int reprc ) {
     py::list l;
-
-    for( int i = 0; i < count; ++i ) {
-        switch( reprc ) {
-            case DLIS_FSHORT: l.append( conv::fshort( xs ) ); break;
-            case DLIS_FSINGL: l.append( conv::fsingl( xs ) ); break;
-            case DLIS_FSING1: l.append( conv::fsing1( xs ) ); break;
-            case DLIS_FSING2: l.append( conv::fsing2( xs ) ); break;
-            case DLIS_ISINGL: l.append( conv::isingl( xs ) ); break;
-            case DLIS_VSINGL: l.append( conv::vsingl( xs ) ); break;
-            case DLIS_FDOUBL: l.append( conv::fdoubl( xs ) ); break;
-            case DLIS_FDOUB1: l.append( conv::fdoub1( xs ) ); break;
-            case DLIS_FDOUB2: l.append( conv::fdoub2( xs ) ); break;
-            case DLIS_CSINGL: l.append( conv::csingl( xs ) ); break;
-            case DLIS_CDOUBL: l.append( conv::cdoubl( xs ) ); break;
-            case DLIS_SSHORT: l.append( conv::sshort( xs ) ); break;
-            case DLIS_SNORM:  l.append( conv:: snorm( xs ) ); break;
-            case DLIS_SLONG:  l.append( conv:: slong( xs ) ); break;
-            case DLIS_USHORT: l.append( conv::ushort( xs ) ); break;
-            case DLIS_UNORM:  l.append( conv:: unorm( xs ) ); break;
-            case DLIS_ULONG:  l.append( conv:: ulong( xs ) ); break;
-            case DLIS_UVARI:  l.append( conv:: uvari( xs ) ); break;
-            case DLIS_IDENT:  l.append( conv:: ident( xs ) ); break;
-            case DLIS_ASCII:  l.append( conv:: ascii( xs ) ); break;
-            case DLIS_DTIME:  l.append( conv:: dtime( xs ) ); break;
-            case DLIS_STATUS: l.append( conv::status( xs ) ); break;
-            case DLIS_ORIGIN: l.append( conv::origin( xs ) ); break;
-            case DLIS_OBNAME: l.append( conv::obname( xs ) ); break;
-            case DLIS_OBJREF: l.append( conv::objref( xs ) ); break;
-            case DLIS_UNITS:  l.append( conv:: ident( xs ) ); break;
-
-            default:
-                throw py::value_error( "unknown representation code "
-                                     + std::to_string( reprc ) );
-        }
-    }
-
+    const append_values vis{ xs, count, l };
+    dl::visit_reprc( representation( reprc ), vis );
     return l;
 }
 
-void skiparray( const char*& xs, int count, int reprc ) {
-    for( int i = 0; i < count; ++i ) {
-        switch( reprc ) {
-            case DLIS_FSHORT: conv::fshort( xs ); break;
-            case DLIS_FSINGL: conv::fsingl( xs ); break;
-            case DLIS_FSING1: conv::fsing1( xs ); break;
-            case DLIS_FSING2: conv::fsing2( xs ); break;
-            case DLIS_ISINGL: conv::isingl( xs ); break;
-            case DLIS_VSINGL: conv::vsingl( xs ); break;
-            case DLIS_FDOUBL: conv::fdoubl( xs ); break;
-            case DLIS_FDOUB1: conv::fdoub1( xs ); break;
-            case DLIS_FDOUB2: conv::fdoub2( xs ); break;
-            case DLIS_CSINGL: conv::csingl( xs ); break;
-            case DLIS_CDOUBL: conv::cdoubl( xs ); break;
-            case DLIS_SSHORT: conv::sshort( xs ); break;
-            case DLIS_SNORM:  conv:: snorm( xs ); break;
-            case DLIS_SLONG:  conv:: slong( xs ); break;
-            case DLIS_USHORT: conv::ushort( xs ); break;
-            case DLIS_UNORM:  conv:: unorm( xs ); break;
-            case DLIS_ULONG:  conv:: ulong( xs ); break;
-            case DLIS_UVARI:  conv:: uvari( xs ); break;
-            case DLIS_IDENT:  conv:: ident( xs ); break;
-            case DLIS_ASCII:  conv:: ascii( xs ); break;
-            case DLIS_DTIME:  conv:: dtime( xs ); break;
-            case DLIS_STATUS: conv::status( xs ); break;
-            case DLIS_ORIGIN: conv::origin( xs ); break;
-            case DLIS_OBNAME: conv::obname( xs ); break;
-            case DLIS_OBJREF: conv::objref( xs ); break;
-            case DLIS_UNITS:  conv:: ident( xs ); break;
-
-            default:
-                throw py::value_error( "unknown representation code "
-                                     + std::to_string( reprc ) );
-        }
-    }
-}
-
 struct setattr {
     int type, name;
 };
@@ -800,69 +898,174 @@ py::dict eflr( const char* cur, const char* end ) {
     return record;
 }
 
-std::vector< char > catrecord( File& fp, int remaining ) {
+const char* file::record_at( const dl::bookmark& mark ) {
+    this->fs.seek( mark.tell );
+    dl::view_record( this->fs, mark.residual, this->record );
+    return this->record.data( this->scratch );
+}
 
-    std::vector< char > cat;
-    cat.reserve( 8192 );
+py::bytes file::raw_record( const dl::bookmark& m ) {
+    const auto* ptr = this->record_at( m );
+    return py::bytes( ptr, this->record.size() );
+}
 
-    while( true ) {
+py::dict file::eflr( const dl::bookmark& mark ) {
+    if( mark.isencrypted ) return py::none();
 
-        while( remaining > 0 ) {
-
-            auto seg = segment_header( fp );
-            remaining -= seg.len;
-
-            int explicit_formatting = 0;
-            int has_predecessor = 0;
-            int has_successor = 0;
-            int is_encrypted = 0;
-            int has_encryption_packet = 0;
-            int has_checksum = 0;
-            int has_trailing_length = 0;
-            int has_padding = 0;
-            dlis_segment_attributes( seg.attrs, &explicit_formatting,
-                                                &has_predecessor,
-                                                &has_successor,
-                                                &is_encrypted,
-                                                &has_encryption_packet,
-                                                &has_checksum,
-                                                &has_trailing_length,
-                                                &has_padding );
-
-
-            seg.len -= 4; // size of LRSH
-            const auto prevsize = cat.size();
-            cat.resize( prevsize + seg.len );
-            fp.read( cat.data() + prevsize, seg.len );
-
-            if( has_trailing_length ) cat.erase( cat.end() - 2, cat.end() );
-            if( has_checksum )        cat.erase( cat.end() - 2, cat.end() );
-            if( has_padding ) {
-                std::uint8_t padbytes = 0;
-                dlis_ushort( cat.data() + cat.size() - 1, &padbytes );
-                cat.erase( cat.end() - padbytes, cat.end() );
-            }
+    const auto* ptr = this->record_at( mark );
+    return ::eflr( ptr, ptr + this->record.size() );
+}
 
-            if( !has_successor ) return cat;
-        }
+/*
+ * Find one channel of an IFLR by applying the frame plan, and return a
+ * pointer to its values. Channels with a frame-independent offset are sliced
+ * out of the record directly, so only their bytes are read, while channels
+ * after a variable-size channel need the frame body to find their offset.
+ * Throws std::out_of_range if the channel is not inside the record
+ */
+const char* channel_values( const dl::record_view& record,
+                            std::vector< char >& scratch,
+                            const dl::frame_plan& plan,
+                            std::size_t channel ) {
 
-        remaining = visible_length( fp ) - 4;
+    /*
+     * The record starts with the obname and frame number, which is at most
+     * 4 (origin) + 1 (copy) + 256 (id) + 4 (frame number) bytes
+     */
+    const auto headerlen = std::min< std::size_t >( record.size(), 265 );
+    const char* header = record.slice( 0, headerlen, scratch );
+    const char* ptr = header;
+
+    ptr = dlis_skip_bounded( DLIS_OBNAME, ptr, header + headerlen, 1 );
+    if( ptr )
+        ptr = dlis_skip_bounded( DLIS_UVARI, ptr, header + headerlen, 1 );
+    if( !ptr )
+        throw std::out_of_range( "iflr: header past end-of-record" );
+
+    const auto bodypos = static_cast< std::size_t >( ptr - header );
+
+    if( plan.fixed( channel ) ) {
+        /* slice() throws if bodypos + offset + width is past the record */
+        const auto offset = plan.offset( channel, nullptr, nullptr );
+        const auto len = plan.width( channel );
+        return record.slice( bodypos + offset, len, scratch );
     }
+
+    const char* data = record.data( scratch );
+    const char* body = data + bodypos;
+    const char* end  = data + record.size();
+    const char* xs = body + plan.offset( channel, body, end );
+    const auto count = plan.count( channel );
+    if( !dlis_skip_bounded( plan.reprc( channel ), xs, end, count ) )
+        throw std::out_of_range( "iflr: channel past end-of-record" );
+
+    return xs;
 }
 
-py::bytes file::raw_record( const dl::bookmark& m ) {
-    this->fs.seek( m.tell );
+py::object iflr( const dl::record_view& record,
+                 std::vector< char >& scratch,
+                 const dl::frame_plan& plan,
+                 std::size_t channel ) {
+    const char* xs = channel_values( record, scratch, plan, channel );
+    return getarray( xs, plan.count( channel ), plan.reprc( channel ) );
+}
 
-    auto cat = catrecord( this->fs, m.residual );
-    return py::bytes( cat.data(), cat.size() );
+/*
+ * Decode a fixed-size channel of every record straight into a (records,
+ * count) array with dlis_decode_strided. There is one frame per IFLR, so
+ * every record is its own run of one frame.
+ *
+ * Returns None if any record is encrypted or can't be decoded, so that the
+ * caller can fall back to the per-value decoding, which reports it.
+ */
+template< typename T >
+py::object decode_curve( dl::record_batch& batch,
+                         std::vector< char >& scratch,
+                         const dl::frame_plan& plan,
+                         std::size_t channel ) {
+    const auto count = std::size_t( plan.count( channel ) );
+    const auto reprc = plan.reprc( channel );
+
+    py::array_t< T > curve( std::vector< std::size_t >{ batch.size(), count } );
+    T* out = curve.mutable_data();
+
+    bool decoded = true;
+    {
+        py::gil_scoped_release nogil;
+        for( std::size_t i = 0; decoded && i < batch.size(); ++i ) {
+            if( batch.mark( i ).isencrypted ) {
+                decoded = false;
+                break;
+            }
+
+            try {
+                const char* xs = channel_values( batch[ i ], scratch, plan, channel );
+                const auto err = dlis_decode_strided( reprc, xs, 0, 0, count, 1,
+                                                      out + i * count );
+                decoded = err == 0;
+            } catch( const std::exception& ) {
+                decoded = false;
+            }
+        }
+    }
+
+    if( !decoded ) return py::none();
+    return std::move( curve );
 }
 
-py::dict file::eflr( const dl::bookmark& mark ) {
-    if( mark.isencrypted ) return py::none();
-    this->fs.seek( mark.tell );
+/*
+ * The plain numerical types have a numpy counterpart, and are decoded in
+ * bulk. The others, e.g. complex, validated or date-time values, become
+ * python objects
+ */
+py::object decode_curve( dl::record_batch& batch,
+                         std::vector< char >& scratch,
+                         const dl::frame_plan& plan,
+                         std::size_t channel ) {
+    if( !plan.fixed( channel ) ) return py::none();
+
+    switch( plan.reprc( channel ) ) {
+        case DLIS_FSHORT:
+        case DLIS_FSINGL:
+        case DLIS_ISINGL:
+        case DLIS_VSINGL:
+            return decode_curve< float >( batch, scratch, plan, channel );
+        case DLIS_FDOUBL:
+            return decode_curve< double >( batch, scratch, plan, channel );
+        case DLIS_SSHORT:
+            return decode_curve< std::int8_t >( batch, scratch, plan, channel );
+        case DLIS_SNORM:
+            return decode_curve< std::int16_t >( batch, scratch, plan, channel );
+        case DLIS_SLONG:
+            return decode_curve< std::int32_t >( batch, scratch, plan, channel );
+        case DLIS_USHORT:
+            return decode_curve< std::uint8_t >( batch, scratch, plan, channel );
+        case DLIS_UNORM:
+            return decode_curve< std::uint16_t >( batch, scratch, plan, channel );
+        case DLIS_ULONG:
+            return decode_curve< std::uint32_t >( batch, scratch, plan, channel );
+        default:
+            return py::none();
+    }
+}
+
+/*
+ * The plan of an ad-hoc frame layout, given as the (count, reprc) of the
+ * channels before the wanted one
+ */
+dl::frame_plan adhoc_plan( const std::vector< std::tuple< int, int > >& pre,
+                           int elems,
+                           int dtype ) {
+    std::vector< int > reprcs;
+    std::vector< int > counts;
+    for( const auto& pair : pre ) {
+        counts.push_back( std::get< 0 >( pair ) );
+        reprcs.push_back( std::get< 1 >( pair ) );
+    }
 
-    auto cat = catrecord( this->fs, mark.residual );
-    return ::eflr( cat.data(), cat.data() + cat.size() );
+    counts.push_back( elems );
+    reprcs.push_back( dtype );
+    return dl::frame_plan( reprcs, counts );
 }
 
 py::object file::iflr_chunk( const dl::bookmark& mark,
@@ -873,101 +1076,140 @@ py::object file::iflr_chunk( const dl::bookmark& mark,
     if( mark.isencrypted ) return py::none();
 
     this->fs.seek( mark.tell );
+    dl::view_record( this->fs, mark.residual, this->record );
+    const auto plan = adhoc_plan( pre, elems, dtype );
+    return iflr( this->record, this->scratch, plan, pre.size() );
+}
+
+py::object file::iflr_batch( const dl::record_index& index,
+                           const std::vector< std::size_t >& positions,
+                           const std::vector< std::tuple< int, int > >& pre,
+                           int elems,
+                           int dtype ) {
+    const auto plan = adhoc_plan( pre, elems, dtype );
+    return this->curves( index, positions, plan, pre.size() );
+}
+
+/*
+ * The curve of a channel, i.e. its values in every record. Fixed-size
+ * numerical channels are decoded in bulk into a (records, count) array of
+ * the matching numpy type, while others are a list of the values of every
+ * record
+ */
+py::object file::curves( const dl::record_index& index,
+                         const std::vector< std::size_t >& positions,
+                         const dl::frame_plan& plan,
+                         std::size_t channel ) {
+
+    if( channel >= plan.size() )
+        throw py::index_error( "channel out of range" );
+
+    dl::record_batch batch( this->fs, index, positions );
+
+    auto curve = decode_curve( batch, this->scratch, plan, channel );
+    if( !curve.is_none() ) return curve;
 
-    auto cat = catrecord( this->fs, mark.residual );
-    const char* ptr = cat.data();
-
-    conv::obname( ptr );
-    auto frameno = conv::uvari( ptr );
-
-    const auto is_constant_size = [](int reprc) {
-        switch( reprc ) {
-            case DLIS_FSHORT:
-            case DLIS_FSINGL:
-            case DLIS_FSING1:
-            case DLIS_FSING2:
-            case DLIS_ISINGL:
-            case DLIS_VSINGL:
-            case DLIS_FDOUBL:
-            case DLIS_FDOUB1:
-            case DLIS_FDOUB2:
-            case DLIS_CSINGL:
-            case DLIS_CDOUBL:
-            case DLIS_SSHORT:
-            case DLIS_SNORM :
-            case DLIS_SLONG :
-            case DLIS_USHORT:
-            case DLIS_UNORM :
-            case DLIS_ULONG :
-            case DLIS_DTIME :
-                return true;
-            default:
-                return false;
+    /*
+     * records that can't be read, e.g. the last record of a truncated file,
+     * are reported and get None, like the encrypted records
+     */
+    py::list chunks;
+    for( std::size_t i = 0; i < batch.size(); ++i ) {
+        if( batch.mark( i ).isencrypted ) {
+            chunks.append( py::none() );
+            continue;
         }
-    };
 
-    const auto reprsize = [](int reprc) {
-        switch( reprc ) {
-            case DLIS_USHORT:
-            case DLIS_SSHORT:
-                return 1;
-
-            case DLIS_FSHORT:
-            case DLIS_SNORM :
-            case DLIS_UNORM :
-                return 2;
-
-            case DLIS_FSINGL:
-            case DLIS_ISINGL:
-            case DLIS_VSINGL:
-            case DLIS_SLONG :
-            case DLIS_ULONG :
-                return 4;
-
-            case DLIS_FDOUBL:
-            case DLIS_FSING1:
-            case DLIS_CSINGL:
-            case DLIS_DTIME :
-                return 8;
-
-            case DLIS_FSING2:
-                return 12;
-
-            case DLIS_FDOUB1:
-            case DLIS_CDOUBL:
-                return 16;
-
-            case DLIS_FDOUB2:
-                return 24;
-
-            default:
-                throw std::runtime_error( "unknown reprc" );
+        try {
+            chunks.append( iflr( batch[ i ], this->scratch, plan, channel ) );
+        } catch( const std::exception& e ) {
+            py::print( e.what(), " at ", positions[ i ] + 1 );
+            chunks.append( py::none() );
         }
-    };
+    }
 
-    bool constant_size = true;
-    int size = 0;
-    for( const auto& pair : pre ) {
-        const auto count = std::get< 1 >( pair );
-        const auto reprc = std::get< 1 >( pair );
-        constant_size = constant_size && is_constant_size( reprc );
+    return chunks;
+}
+
+py::tuple pyname( const dl::obname& name ) {
+    return py::make_tuple( static_cast< std::int32_t >( name.origin ),
+                           static_cast< std::uint8_t >( name.copy ),
+                           static_cast< const std::string& >( name.id ) );
+}
+
+/*
+ * Parse the CHANNEL and FRAME sets among the explicit records into typed
+ * objects, resolve the channels of every frame, and compile the frame plans,
+ * without going through the python dicts of eflr(). Returns
+ * { frame: (channels, plan) }. Records that can't be parsed are reported and
+ * skipped, like explicits.oftype does, and so are frames whose channels
+ * can't be resolved. The records are parsed on threads threads, without the
+ * GIL
+ */
+py::dict file::frameplans( const dl::record_index& index,
+                           const std::vector< std::size_t >& positions,
+                           int threads ) {
+    std::vector< std::size_t > wanted;
+    for( const auto pos : positions ) {
+        const int type = index.types.at( pos );
+        if( type == DLIS_CHANNL || type == DLIS_FRAME )
+            wanted.push_back( pos );
+    }
 
-        size += count * reprsize( reprc );
+    std::vector< dl::object_set > parsed;
+    std::vector< std::exception_ptr > errors;
+    {
+        py::gil_scoped_release nogil;
+        parsed = dl::parse_eflrs( this->fs, index, wanted, threads, &errors );
     }
 
-    if ( !constant_size ) {
-        for( auto& pair : pre ) {
-            auto count = std::get< 0 >( pair );
-            auto reprc = std::get< 1 >( pair );
+    std::vector< dl::object_set > sets;
+    for( std::size_t i = 0; i < parsed.size(); ++i ) {
+        if( index[ wanted[ i ] ].isencrypted ) continue;
 
-            skiparray( ptr, count, reprc );
+        if( errors[ i ] ) try {
+            std::rethrow_exception( errors[ i ] );
+        } catch( const std::exception& e ) {
+            py::print( e.what(), " at ", wanted[ i ] + 1 );
+            continue;
         }
+
+        sets.push_back( std::move( parsed[ i ] ) );
     }
-    else {
-        ptr += size;
+
+    const dl::channel_index channels( sets );
+
+    py::dict plans;
+    for( const auto& set : sets ) {
+        using frames = std::vector< dl::frame >;
+        const auto* fs = boost::get< frames >( &set.objects );
+        if( !fs ) continue;
+
+        for( const auto& frame : *fs ) {
+            /*
+             * a frame that names a missing channel, e.g. from a CHANNEL set
+             * that failed to parse, is reported and skipped on its own
+             */
+            dl::frame_plan plan;
+            try {
+                plan = dl::make_frame_plan( channels.resolve( frame ) );
+            } catch( const std::exception& e ) {
+                py::print( e.what(), " in frame ", frame.get_name() );
+                continue;
+            }
+
+            py::list names;
+            for( const auto& name : frame.channels )
+                names.append( pyname( name ) );
+
+            plans[ pyname( frame.object_name ) ] = py::make_tuple(
+                names,
+                std::move( plan )
+            );
+        }
     }
 
-    return getarray( ptr, elems, dtype );
+    return plans;
 }
 
 }
@@ -988,6 +1230,7 @@ PYBIND11_MODULE(core, m) {
     py::class_< dl::bookmark >( m, "bookmark" )
         .def_readwrite( "encrypted", &dl::bookmark::isencrypted )
         .def_readwrite( "explicit",  &dl::bookmark::isexplicit )
+        .def_readwrite( "type",      &dl::bookmark::type )
         .def( "__repr__", []( const dl::bookmark& m ) {
             auto pos = " pos=" + std::to_string( m.tell );
             auto enc = std::string(" encrypted=") +
@@ -998,6 +1241,86 @@ PYBIND11_MODULE(core, m) {
         })
     ;
 
+    /*
+     * the index is read-only from python. The columns are exposed as numpy
+     * arrays that borrow the memory of the index, and indexing re-creates
+     * the bookmark
+     */
+    py::class_< dl::record_index >( m, "index" )
+        .def( "__len__", &dl::record_index::size )
+        .def( "__getitem__", []( const dl::record_index& index, long i ) {
+            const auto size = static_cast< long >( index.size() );
+            if( i < 0 ) i += size;
+            if( i < 0 || i >= size )
+                throw py::index_error( "index out of range" );
+            return index[ i ];
+        })
+        .def_property_readonly( "tell", []( py::object self ) {
+            const auto& index = self.cast< const dl::record_index& >();
+            return py::array_t< std::int64_t >( index.tells.size(),
+                                                index.tells.data(),
+                                                self );
+        })
+        .def_property_readonly( "residual", []( py::object self ) {
+            const auto& index = self.cast< const dl::record_index& >();
+            return py::array_t< std::int32_t >( index.residuals.size(),
+                                                index.residuals.data(),
+                                                self );
+        })
+        .def_property_readonly( "flags", []( py::object self ) {
+            const auto& index = self.cast< const dl::record_index& >();
+            return py::array_t< std::uint8_t >( index.flags.size(),
+                                                index.flags.data(),
+                                                self );
+        })
+        .def_property_readonly( "type", []( py::object self ) {
+            const auto& index = self.cast< const dl::record_index& >();
+            return py::array_t< std::uint8_t >( index.types.size(),
+                                                index.types.data(),
+                                                self );
+        })
+        .def_property_readonly( "nameid", []( py::object self ) {
+            const auto& index = self.cast< const dl::record_index& >();
+            return py::array_t< std::int32_t >( index.nameids.size(),
+                                                index.nameids.data(),
+                                                self );
+        })
+        .def_property_readonly( "names", []( const dl::record_index& index ) {
+            py::list names;
+            for( const auto& name : index.names ) {
+                names.append( py::make_tuple(
+                    static_cast< std::int32_t >( name.origin ),
+                    static_cast< std::uint8_t >( name.copy ),
+                    static_cast< const std::string& >( name.id )
+                ));
+            }
+            return names;
+        })
+        .def_property_readonly_static( "EXPLICIT", []( py::object ) {
+            return int( dl::record_index::explicit_record );
+        })
+        .def_property_readonly_static( "ENCRYPTED", []( py::object ) {
+            return int( dl::record_index::encrypted_record );
+        })
+    ;
+
+    /*
+     * the compiled layout of a frame, built once per FRAME from the
+     * (reprc, count) of its channels, and used to decode all its IFLRs
+     */
+    py::class_< dl::frame_plan >( m, "frameplan" )
+        .def( py::init< const std::vector< int >&,
+                        const std::vector< int >& >(),
+              "reprcs"_a, "counts"_a )
+        .def( "__len__", &dl::frame_plan::size )
+        .def( "fixed",   &dl::frame_plan::fixed )
+        .def( "width",   &dl::frame_plan::width )
+        .def( "__repr__", []( const dl::frame_plan& plan ) {
+            return "<dlisio.core.frameplan channels="
+                 + std::to_string( plan.size() ) + ">";
+        })
+    ;
+
     m.def( "sul", []( const std::string& b ) {
         if( b.size() < 80 ) {
             throw py::value_error(
@@ -1021,9 +1344,16 @@ PYBIND11_MODULE(core, m) {
         .def( "close", &file::close )
 
         .def( "sul",        &file::sul )
-        .def( "mkindex",    &file::mkindex )
+        .def( "mkindex",    &file::mkindex, "threads"_a = 1,
+                                            "sidecar"_a = "",
+                                            "recover"_a = false )
         .def( "raw_record", &file::raw_record )
         .def( "eflr",       &file::eflr )
         .def( "iflr",       &file::iflr_chunk )
+        .def( "iflrs",      &file::iflr_batch )
+        .def( "curves",     &file::curves )
+        .def( "frameplans", &file::frameplans, "index"_a,
+                                                "positions"_a,
+                                                "threads"_a = 1 )
         ;
 }
@@ -276,3 +276,33 @@ def test_conv():
                     ])
 
     assert dlisio.core.conv(19, dim) == "DIMENSION"
+
+class broken_eflrs(object):
+    """A file where the explicit records in broken fail to parse"""
+    def __init__(self, broken):
+        self.broken = broken
+
+    def eflr(self, mark):
+        if mark in self.broken:
+            raise RuntimeError('broken record')
+        return { 'mark': mark }
+
+class marks(list):
+    @property
+    def type(self):
+        return [3, 4, 3, 4]
+
+def test_explicits_iteration_skips_broken_records(capsys):
+    fp = broken_eflrs(broken = [1])
+    ex = dlisio.explicits(fp, marks([0, 1, 2, 3]), [0, 1, 2, 3])
+
+    assert [record['mark'] for record in ex] == [0, 2, 3]
+    assert 'broken record' in capsys.readouterr().out
+
+    assert [i for i, _ in ex.oftype(dlisio.explicits.FRAME)] == [3]
+    assert 'at  2' in capsys.readouterr().out
+
+    with pytest.raises(RuntimeError):
+        _ = ex[1]
+
+    assert ex[-1]['mark'] == 3